@@ -0,0 +1,556 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   loadgen.cpp                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: anemet <anemet@student.42luxembourg.lu>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/09/01 11:05:00 by anemet            #+#    #+#             */
+/*   Updated: 2026/09/01 11:05:00 by anemet           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+/*
+	=================================================================
+		LOADGEN - epoll-based HTTP load generator (make bench)
+	=================================================================
+
+	Standalone benchmark harness for webserv. Until now every
+	performance claim about the server was folklore: the .test/
+	directory holds unit-style mains, but nothing measured
+	throughput or latency. This tool does, with the same event-loop
+	techniques as the server itself (non-blocking sockets + epoll),
+	so the generator doesn't become the bottleneck it is measuring.
+
+	Usage:
+		./bench/loadgen [options]
+			-h <host>   target host        (default 127.0.0.1)
+			-p <port>   target port        (default 8080)
+			-c <n>      concurrent connections (default 10)
+			-n <n>      total requests     (default 10000)
+			-u <file>   request paths, one per line, cycled
+			            (default: "/" only)
+
+	Each connection keeps one request in flight at a time over a
+	keep-alive connection (closed-loop load). Reported numbers:
+
+		- requests/sec (RPS)
+		- p50 / p99 / p999 latency (request write -> response complete)
+		- bytes/sec received
+
+	Example session:
+		make bench
+		./webserv config/default.conf &
+		./bench/loadgen -c 50 -n 100000 -u bench/paths.txt
+
+	Framing: responses are delimited by Content-Length (or by
+	connection close). That covers everything the static and error
+	paths produce; chunked responses (streamed CGI) are out of
+	scope for a throughput harness.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <cctype>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <signal.h>
+
+// Per-connection receive buffer for recv() calls
+static const size_t RECV_CHUNK = 65536;
+
+/*
+	Conn - One benchmark connection's state machine
+
+	Mirrors (in miniature) the server's Connection: a send buffer
+	with an offset, a parse state for the response, and latency
+	bookkeeping. Each Conn runs request -> response -> next request
+	until the global budget is spent.
+*/
+struct Conn
+{
+	int				fd;
+	std::string		sendBuf;		// Current request bytes
+	size_t			sendOff;		// How much of sendBuf is out
+	std::string		recvBuf;		// Response bytes collected so far
+	bool			headersDone;	// Seen \r\n\r\n?
+	size_t			bodyNeed;		// Content-Length remaining
+	bool			closeDelimited;	// No Content-Length: read to EOF
+	struct timeval	startTime;		// When the request was sent
+	size_t			pathIndex;		// Next path to request (round-robin)
+
+	Conn() : fd(-1), sendOff(0), headersDone(false),
+				bodyNeed(0), closeDelimited(false), pathIndex(0)
+	{}
+};
+
+/*
+	Stats - Global benchmark counters
+
+	Latencies are kept in full (8 bytes per request) so percentiles
+	are exact, not estimated from histogram buckets.
+*/
+struct Stats
+{
+	unsigned long			completed;
+	unsigned long			errors;
+	unsigned long long		bytesReceived;
+	std::vector<double>		latenciesMs;
+
+	Stats() : completed(0), errors(0), bytesReceived(0)
+	{}
+};
+
+// Microsecond wall clock as a double (milliseconds)
+static double elapsedMs(const struct timeval& from, const struct timeval& to)
+{
+	return (to.tv_sec - from.tv_sec) * 1000.0
+			+ (to.tv_usec - from.tv_usec) / 1000.0;
+}
+
+static bool setNonBlocking(int fd)
+{
+	int flags = fcntl(fd, F_GETFL, 0);
+	if (flags < 0)
+	{
+		return false;
+	}
+	return fcntl(fd, F_SETFL, flags | O_NONBLOCK) >= 0;
+}
+
+/*
+	connectTarget() - Open a non-blocking connection to the server
+
+	connect() on a non-blocking socket returns EINPROGRESS; the
+	epoll loop learns completion via EPOLLOUT, which is also the
+	signal to start writing the first request - no special case.
+*/
+static int connectTarget(const std::string& host, int port)
+{
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0)
+	{
+		return -1;
+	}
+	if (!setNonBlocking(fd))
+	{
+		close(fd);
+		return -1;
+	}
+
+	// Benchmark tool: latency numbers shouldn't include Nagle delays
+	int one = 1;
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+	struct sockaddr_in addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1)
+	{
+		close(fd);
+		return -1;
+	}
+
+	if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0
+		&& errno != EINPROGRESS)
+	{
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+// Build one GET request for the given path
+static std::string buildRequest(const std::string& host, const std::string& path)
+{
+	std::string req = "GET ";
+	req += path;
+	req += " HTTP/1.1\r\nHost: ";
+	req += host;
+	req += "\r\nConnection: keep-alive\r\n\r\n";
+	return req;
+}
+
+/*
+	parseResponse() - Consume response bytes, return true when complete
+
+	Minimal HTTP framing: find the header/body boundary, read
+	Content-Length, then count body bytes. Headers are scanned
+	case-insensitively the cheap way (the server emits canonical
+	casing, but nginx and friends don't always).
+*/
+static bool parseResponse(Conn& c)
+{
+	if (!c.headersDone)
+	{
+		size_t pos = c.recvBuf.find("\r\n\r\n");
+		if (pos == std::string::npos)
+		{
+			return false;
+		}
+		c.headersDone = true;
+
+		// Locate Content-Length in the header block
+		c.closeDelimited = true;
+		std::string headers = c.recvBuf.substr(0, pos);
+		for (size_t i = 0; i < headers.size(); i++)
+		{
+			headers[i] = std::tolower(headers[i]);
+		}
+		size_t cl = headers.find("content-length:");
+		if (cl != std::string::npos)
+		{
+			c.bodyNeed = std::strtoul(headers.c_str() + cl + 15, NULL, 10);
+			c.closeDelimited = false;
+		}
+
+		// Body bytes already buffered behind the headers count
+		size_t have = c.recvBuf.size() - (pos + 4);
+		if (!c.closeDelimited)
+		{
+			c.bodyNeed = (have >= c.bodyNeed) ? 0 : c.bodyNeed - have;
+		}
+		c.recvBuf.clear();	// Only byte COUNTS matter from here on
+	}
+	else if (!c.recvBuf.empty())
+	{
+		size_t have = c.recvBuf.size();
+		if (!c.closeDelimited)
+		{
+			c.bodyNeed = (have >= c.bodyNeed) ? 0 : c.bodyNeed - have;
+		}
+		c.recvBuf.clear();
+	}
+
+	return !c.closeDelimited && c.headersDone && c.bodyNeed == 0;
+}
+
+// Percentile from a SORTED latency vector (nearest-rank)
+static double percentile(const std::vector<double>& sorted, double p)
+{
+	if (sorted.empty())
+	{
+		return 0.0;
+	}
+	size_t rank = (size_t)(p * sorted.size());
+	if (rank >= sorted.size())
+	{
+		rank = sorted.size() - 1;
+	}
+	return sorted[rank];
+}
+
+int main(int argc, char** argv)
+{
+	std::string host = "127.0.0.1";
+	int port = 8080;
+	size_t concurrency = 10;
+	unsigned long totalRequests = 10000;
+	std::vector<std::string> paths;
+
+	// ----- Argument parsing -----
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "-h" && i + 1 < argc)
+			host = argv[++i];
+		else if (arg == "-p" && i + 1 < argc)
+			port = std::atoi(argv[++i]);
+		else if (arg == "-c" && i + 1 < argc)
+			concurrency = std::strtoul(argv[++i], NULL, 10);
+		else if (arg == "-n" && i + 1 < argc)
+			totalRequests = std::strtoul(argv[++i], NULL, 10);
+		else if (arg == "-u" && i + 1 < argc)
+		{
+			std::ifstream file(argv[++i]);
+			std::string line;
+			while (std::getline(file, line))
+			{
+				if (!line.empty() && line[0] == '/')
+				{
+					paths.push_back(line);
+				}
+			}
+		}
+		else
+		{
+			std::cerr << "Usage: " << argv[0]
+					  << " [-h host] [-p port] [-c conns] [-n requests]"
+					  << " [-u paths-file]" << std::endl;
+			return 1;
+		}
+	}
+	if (paths.empty())
+	{
+		paths.push_back("/");
+	}
+	if (concurrency == 0 || totalRequests == 0)
+	{
+		std::cerr << "Error: -c and -n must be positive" << std::endl;
+		return 1;
+	}
+
+	// A dying server mid-run must not kill the tool with SIGPIPE
+	signal(SIGPIPE, SIG_IGN);
+
+	int epollFd = epoll_create(1);
+	if (epollFd < 0)
+	{
+		std::cerr << "epoll_create failed: " << strerror(errno) << std::endl;
+		return 1;
+	}
+
+	Stats stats;
+	stats.latenciesMs.reserve(totalRequests);
+	std::vector<Conn*> conns;		// fd -> Conn (like the server's table)
+	unsigned long issued = 0;		// Requests handed to connections
+	size_t nextPath = 0;
+
+	// ----- Open the initial connection pool -----
+	for (size_t i = 0; i < concurrency && issued < totalRequests; i++)
+	{
+		int fd = connectTarget(host, port);
+		if (fd < 0)
+		{
+			std::cerr << "connect failed: " << strerror(errno) << std::endl;
+			return 1;
+		}
+		Conn* c = new Conn();
+		c->fd = fd;
+		c->pathIndex = nextPath++ % paths.size();
+		c->sendBuf = buildRequest(host, paths[c->pathIndex]);
+		++issued;
+
+		if ((size_t)fd >= conns.size())
+		{
+			conns.resize(fd + 1, NULL);
+		}
+		conns[fd] = c;
+
+		struct epoll_event ev;
+		std::memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLOUT | EPOLLIN;
+		ev.data.fd = fd;
+		epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+	}
+
+	struct timeval benchStart;
+	gettimeofday(&benchStart, NULL);
+
+	size_t active = std::min(concurrency, (size_t)totalRequests);
+	char buffer[RECV_CHUNK];
+	struct epoll_event events[256];
+
+	// ================================
+	//  Event loop
+	// ================================
+	while (active > 0)
+	{
+		int n = epoll_wait(epollFd, events, 256, 1000);
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+
+		for (int i = 0; i < n; i++)
+		{
+			int fd = events[i].data.fd;
+			Conn* c = conns[fd];
+			if (!c)
+				continue;
+			bool dead = false;
+
+			// ----- Write side: push the pending request out -----
+			if (events[i].events & EPOLLOUT)
+			{
+				while (c->sendOff < c->sendBuf.size())
+				{
+					ssize_t sent = send(fd, c->sendBuf.data() + c->sendOff,
+										c->sendBuf.size() - c->sendOff, 0);
+					if (sent > 0)
+					{
+						if (c->sendOff == 0)
+						{
+							gettimeofday(&c->startTime, NULL);
+						}
+						c->sendOff += sent;
+					}
+					else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+					{
+						break;
+					}
+					else
+					{
+						dead = true;
+						break;
+					}
+				}
+			}
+
+			// ----- Read side: collect and frame the response -----
+			if (!dead && (events[i].events & (EPOLLIN | EPOLLHUP)))
+			{
+				while (true)
+				{
+					ssize_t got = recv(fd, buffer, sizeof(buffer), 0);
+					if (got > 0)
+					{
+						stats.bytesReceived += got;
+						c->recvBuf.append(buffer, got);
+						if (parseResponse(*c))
+						{
+							// Response complete: record and move on
+							struct timeval now;
+							gettimeofday(&now, NULL);
+							stats.latenciesMs.push_back(
+								elapsedMs(c->startTime, now));
+							++stats.completed;
+
+							if (issued < totalRequests)
+							{
+								// Reuse the keep-alive connection
+								c->pathIndex = nextPath++ % paths.size();
+								c->sendBuf = buildRequest(host,
+												paths[c->pathIndex]);
+								c->sendOff = 0;
+								c->recvBuf.clear();
+								c->headersDone = false;
+								c->bodyNeed = 0;
+								c->closeDelimited = false;
+								++issued;
+
+								struct epoll_event ev;
+								std::memset(&ev, 0, sizeof(ev));
+								ev.events = EPOLLOUT | EPOLLIN;
+								ev.data.fd = fd;
+								epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev);
+							}
+							else
+							{
+								dead = true;	// Budget spent
+							}
+							break;
+						}
+					}
+					else if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+					{
+						break;
+					}
+					else
+					{
+						// EOF: valid end for close-delimited responses
+						if (c->headersDone && c->closeDelimited)
+						{
+							struct timeval now;
+							gettimeofday(&now, NULL);
+							stats.latenciesMs.push_back(
+								elapsedMs(c->startTime, now));
+							++stats.completed;
+						}
+						else
+						{
+							++stats.errors;
+						}
+						dead = true;
+						break;
+					}
+				}
+			}
+
+			if (dead)
+			{
+				epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
+				close(fd);
+				conns[fd] = NULL;
+				delete c;
+				--active;
+
+				// Keep-alive refused or error: reconnect to keep the
+				// requested concurrency if there is budget left
+				if (issued < totalRequests)
+				{
+					int nfd = connectTarget(host, port);
+					if (nfd >= 0)
+					{
+						Conn* nc = new Conn();
+						nc->fd = nfd;
+						nc->pathIndex = nextPath++ % paths.size();
+						nc->sendBuf = buildRequest(host, paths[nc->pathIndex]);
+						++issued;
+						if ((size_t)nfd >= conns.size())
+						{
+							conns.resize(nfd + 1, NULL);
+						}
+						conns[nfd] = nc;
+						struct epoll_event ev;
+						std::memset(&ev, 0, sizeof(ev));
+						ev.events = EPOLLOUT | EPOLLIN;
+						ev.data.fd = nfd;
+						epoll_ctl(epollFd, EPOLL_CTL_ADD, nfd, &ev);
+						++active;
+					}
+				}
+			}
+		}
+	}
+
+	struct timeval benchEnd;
+	gettimeofday(&benchEnd, NULL);
+	double seconds = elapsedMs(benchStart, benchEnd) / 1000.0;
+	if (seconds <= 0.0)
+	{
+		seconds = 0.001;
+	}
+
+	// ================================
+	//  Report
+	// ================================
+	std::sort(stats.latenciesMs.begin(), stats.latenciesMs.end());
+
+	std::cout << "\n=== loadgen results ===" << std::endl;
+	std::cout << "Target:        " << host << ":" << port
+			  << "  (" << concurrency << " connections)" << std::endl;
+	std::cout << "Completed:     " << stats.completed
+			  << "  (errors: " << stats.errors << ")" << std::endl;
+	std::cout << "Duration:      " << seconds << " s" << std::endl;
+	std::cout << "Requests/sec:  " << (stats.completed / seconds) << std::endl;
+	std::cout << "Bytes/sec:     "
+			  << (unsigned long long)(stats.bytesReceived / seconds) << std::endl;
+	std::cout << "Latency p50:   " << percentile(stats.latenciesMs, 0.50)
+			  << " ms" << std::endl;
+	std::cout << "Latency p99:   " << percentile(stats.latenciesMs, 0.99)
+			  << " ms" << std::endl;
+	std::cout << "Latency p999:  " << percentile(stats.latenciesMs, 0.999)
+			  << " ms" << std::endl;
+
+	// Free whatever survived (errors mid-run)
+	for (size_t i = 0; i < conns.size(); i++)
+	{
+		if (conns[i])
+		{
+			close(conns[i]->fd);
+			delete conns[i];
+		}
+	}
+	close(epollFd);
+
+	return (stats.errors == 0) ? 0 : 1;
+}
@@ -457,6 +457,59 @@ public:
 	CGIResult execute(int timeout = 30);
 
 
+	// ===========================
+	//  Asynchronous CGI Execution
+	// ===========================
+
+	/*
+		AsyncExec - Handle for a CGI child launched with startAsync()
+
+		The caller (the Server's event loop) owns the pipe fds and the
+		child pid after a successful start:
+		- stdinFd:  write the request body here, then close (EOF)
+		- stdoutFd: read the script output here until EOF
+		- pid:      reap with a non-blocking waitpid()
+
+		Both fds are already non-blocking.
+	*/
+	struct AsyncExec
+	{
+		pid_t	pid;		// Child process id
+		int		stdinFd;	// Parent's write end of the stdin pipe
+		int		stdoutFd;	// Parent's read end of the stdout pipe
+
+		AsyncExec() : pid(-1), stdinFd(-1), stdoutFd(-1) {}
+	};
+
+	/*
+		startAsync() - Launch the CGI child without waiting for it
+
+		Performs the pipe/fork/dup2/execve dance of execute() but
+		returns IMMEDIATELY after the fork instead of pumping the
+		pipes in a blocking loop. The Server registers the returned
+		pipe fds with its epoll instance and feeds/drains them
+		incrementally, so one slow script never stalls the loop.
+
+		Prerequisites: setup() must have succeeded (isReady()).
+
+		Parameters:
+			exec: Out - pid and non-blocking pipe fds on success
+
+		Returns:
+			true on success, false on pipe/fork failure
+			(caller should answer 500 on failure)
+	*/
+	bool startAsync(AsyncExec& exec);
+
+	/*
+		parseOutput() - Parse raw CGI output into a CGIResult
+
+		Static: used both by the synchronous execute() path and by
+		the Server once an async child's stdout hits EOF.
+	*/
+	static bool parseOutput(const std::string& output, CGIResult& result);
+
+
 private:
 	// ===========================
 	//  Private Helper Methods
@@ -517,27 +570,6 @@ private:
 	*/
 	std::string extractPathInfo() const;
 
-	/*
-		parseCgiOutput() - Parse CGI output into headers and body
-
-		CGI output format:
-			Header1: Value1\r\n
-			Header2: Value2\r\n
-			\r\n                    <- Empty line separates headers from body
-			<body content>
-
-		This function separates headers from body and parses each header.
-
-		Parameters:
-			output: Raw CGI output string
-			result: CGIResult to populate with parsed data
-
-		Returns:
-			true if output is valid CGI format
-			false if malformed (missing headers or separator)
-	*/
-	bool parseCgiOutput(const std::string& output, CGIResult& result);
-
 	/*
 		setNonBlocking() - Set a file descriptor to non-blocking mode
 
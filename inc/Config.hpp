@@ -39,9 +39,12 @@ struct LocationConfig
 	std::string upload_path;	// Where to store uploaded files
 	std::string cgi_extension;	// File extension that triggers CGI execution (e.g., ".php")
 	std::string cgi_path;		// Path to the CGI interpreter (e.g., "/usr/bin/php-cgi")
+	int cgi_workers;			// Max concurrent CGI children (excess requests queue)
+	size_t cgi_max_output;		// Max bytes a script may emit (0 = unlimited)
 	std::string redirect_url;	// URL to redirect to (for HTTP redirections)
 	int redirect_code;			// HTTP redirect status code (301, 302, etc.)
 	bool autoindex;				// Enable directory listing when no index file exists
+	bool gzip;					// Compress eligible responses (and serve .gz siblings)
 	std::set<std::string> allowed_methods;	// HTTP methods allowed for this route (GET, POST, DELETE)
 
 	// Constructor with sensible defaults
@@ -63,6 +66,9 @@ struct ServerConfig
 	std::vector<std::string> server_names;	// Virtual host names (e.g., "example.com", "www.example.com")
 	std::map<int, std::string> error_pages;	// Custom error pages: status_code ->file_path
 	size_t client_max_body_size;			// Maximum allowed request body size in bytes
+	std::string access_log;					// Access/error log file ("" = stdout)
+	std::string log_level;					// "debug"/"info"/"error"/"none" ("" = info)
+	bool stats;								// Per-stage latency histograms (default off)
 	std::vector<LocationConfig> locations;	// All locations blocks for this server
 
 	// Constructor with sensible defaults
@@ -95,6 +101,9 @@ class Config
 	private:
 		std::vector<ServerConfig> _servers;	// All parsed server blocks
 		std::string _configPath;			// Path to config file
+		int _workerProcesses;				// Number of worker processes (prefork mode)
+		size_t _memoryBudget;				// Total Connection-buffer budget in bytes
+											// (0 = unlimited; see memory_budget directive)
 
 		// Parsing helper methods
 		void parseServerBlock(std::ifstream& file, std::string& line);
@@ -127,6 +136,15 @@ class Config
 		const std::vector<ServerConfig>& getServers() const;
 		const ServerConfig* getServerByHostPort(const std::string& host, int port) const;
 
+		// worker_processes directive (prefork mode, default 1 = single process)
+		int getWorkerProcesses() const;
+
+		// memory_budget directive (0 = unlimited)
+		size_t getMemoryBudget() const;
+
+		// Path of the last file given to parseFile() (for SIGHUP reload)
+		const std::string& getConfigPath() const;
+
 		// Debug: print parsed configuration
 		void printConfig() const;
 };
@@ -118,6 +118,7 @@ enum ConnectionState
 {
 	CONN_READING,	// Reading request from client
 	CONN_WRITING,	// Writing response to client
+	CONN_CGI_WAIT,	// Parked: request handed to an async CGI child
 	CONN_CLOSED,	// Connection closed normally
 	CONN_ERROR		// Error occurred
 };
@@ -260,14 +261,68 @@ bool handleWriteComplete();
 		Called after the Router generates a response for the request.
 
 		Parameters:
-			response: The HTTP response to send
+			response: The HTTP response to send. Non-const because the
+			          body is STOLEN with Response::swapBody() - an O(1)
+			          string swap instead of a full-body copy. The
+			          Response is hollow afterwards, which is fine: every
+			          caller discards it right after this call.
 
 		Side effects:
-		- Stores the response data in write buffer
+		- Stores the header block and body in separate write buffers
+		  (sent together with writev(), never concatenated)
 		- Changes state to CONN_WRITING
 		- Updates keep-alive flag from response
 	*/
-	void setResponse(const Response& response);
+	void setResponse(Response& response);
+
+	/*
+		appendChunk() - Frame a body fragment as an HTTP/1.1 chunk
+
+		Used by the async CGI path to stream script output while the
+		script is still running: each fragment is framed as
+
+			<hex size>\r\n<data>\r\n
+
+		and appended to the outgoing body buffer. The response queued
+		with setResponse() must be in chunked mode (Response::
+		setChunked()); endChunkStream() writes the terminating
+		zero-size chunk. Until then writeData() keeps the connection
+		in CONN_WRITING even when the buffers drain - more fragments
+		are on the way.
+	*/
+	void appendChunk(const char* data, size_t len);
+
+	/*
+		endChunkStream() - Terminate a chunked response
+
+		Queues the final "0\r\n\r\n" frame; once it drains, the
+		response completes normally (keep-alive works as usual -
+		chunked framing has an explicit end marker).
+	*/
+	void endChunkStream();
+
+	/*
+		nextPipelinedRequest() - Advance to the next pipelined request
+
+		HTTP/1.1 clients may send several requests back-to-back without
+		waiting for responses. After a response has been queued, the
+		Server calls this in a loop: each call takes the bytes buffered
+		beyond the previous request, resets the Request object and
+		re-parses.
+
+		Batching stops (returns false) when:
+		- there are no leftover bytes, or only a PARTIAL next request
+		  (the half-parsed Request survives until more data arrives)
+		- the queued response carries a file-backed body (sendfile()
+		  runs after the buffers drain, so more responses can't be
+		  queued behind it without reordering the stream)
+		- the connection isn't keep-alive (a "Connection: close"
+		  response discards any pipelined followers, per HTTP)
+
+		Returns:
+			true if a COMPLETE next request is ready to route
+	*/
+	bool nextPipelinedRequest();
 
 	/*
 		hasCompleteRequest() - Check if we've received a full HTTP request
@@ -337,6 +392,31 @@ bool handleWriteComplete();
 	*/
 	bool isTimedOut(int timeoutSeconds) const;
 
+	/*
+		getTimeoutDeadline() - Phase-aware timeout deadline (Slowloris defense)
+
+		A single idle timeout lets an attacker hold a connection open
+		for the full keep-alive window by trickling one header byte per
+		minute. Instead, the deadline depends on what the connection is
+		doing:
+
+			- Reading the request line / headers: absolute deadline of
+			  headerSec after the FIRST byte of the request. Trickling
+			  bytes does not push it back.
+			- Reading the body: idle-based deadline of bodySec since the
+			  last read (uploads may legitimately pause between chunks).
+			- Fresh connection that has not sent anything: headerSec
+			  after accept() - connect-and-stall costs the same as
+			  header trickling.
+			- Otherwise (keep-alive idle between requests, writing a
+			  response): the normal idle timeout of idleSec.
+
+		Returns:
+			Absolute Unix timestamp after which the connection should
+			be closed.
+	*/
+	time_t getTimeoutDeadline(int idleSec, int headerSec, int bodySec) const;
+
 	/*
 		getLastActivity() - Get timestamp of last activity
 
@@ -374,6 +454,20 @@ bool handleWriteComplete();
 	*/
 	int getServerPort() const;
 
+	/*
+		getCachedVhost() - Memoized Host -> ServerConfig lookup
+
+		Returns the server block cached by cacheVhost() if it was
+		resolved for the same Host header under the same config
+		generation, NULL otherwise (caller resolves and re-caches).
+	*/
+	const ServerConfig* getCachedVhost(const std::string& host,
+										unsigned long generation) const;
+
+	// cacheVhost() - Park a resolved server block for later requests
+	void cacheVhost(const std::string& host, const ServerConfig* server,
+					unsigned long generation);
+
 	/*
 		getClientIP() - Get client's IP address as string
 
@@ -433,6 +527,17 @@ bool handleWriteComplete();
 	*/
 	bool hasDataToWrite() const;
 
+	/*
+		getWriteBacklog() - Unsent bytes queued for this client
+
+		Header + body buffer bytes not yet handed to send(). Used by
+		the CGI streaming backpressure check: when this exceeds the
+		watermark, the Server stops reading the script's stdout until
+		the client catches up. File-backed bytes aren't counted -
+		they live in the page cache, not in our buffers.
+	*/
+	size_t getWriteBacklog() const;
+
 
 
 private:
@@ -446,21 +551,63 @@ private:
 	int					_clientPort;    // Client source port
 	int					_serverPort;    // Server port client connected to
 
+	/*
+		Host -> ServerConfig memo for keep-alive reuse.
+
+		Virtual-host resolution is pure repetition for a connection
+		that sends the same Host header on every request (which is
+		all of them - browsers don't change Host mid-connection).
+		The first request resolves through the Router's server index
+		and parks the answer here; subsequent requests with the same
+		Host reuse it for free. The generation stamp ties the cached
+		pointer to the Config it came from, so a SIGHUP reload
+		(which bumps the Router's generation) forces a re-resolve
+		instead of routing with a retired server block.
+	*/
+	std::string			_vhostHost;     // Host header the memo is for
+	const ServerConfig*	_vhostServer;   // Resolved block (NULL = none)
+	unsigned long		_vhostGeneration; // Router config generation
+
 	// Timestamps for timeout management
 	time_t				_connectTime;   // When connection was established
 	time_t				_lastActivity;  // Last successful I/O operation
+	time_t				_requestFirstByte; // First byte of the current request
+											// (0 = between requests); anchors
+											// the absolute header deadline
+	unsigned long		_requestStartUs; // First byte of the current request
+										 // (0 = none yet; total histogram)
 
 	// Connection state
 	ConnectionState		_state;         // Current state in lifecycle
 	bool				_keepAlive;     // Keep connection open after response?
 
 	// Buffers for HTTP data
+	//
+	// The response is kept as TWO buffers - the serialized header
+	// block and the body - and sent with a single writev() per
+	// wakeup. Concatenating them (the old approach) copied the
+	// full body just to prepend ~200 bytes of headers.
 	std::string			_readBuffer;    // Incoming data from client
-	std::string			_writeBuffer;   // Outgoing data to client
+	std::string			_writeBuffer;   // Outgoing header block
 	size_t				_writeOffset;   // How much of writeBuffer has been sent
+	std::string			_bodyBuffer;    // Outgoing body (swapped in, not copied)
+	size_t				_bodyOffset;    // How much of bodyBuffer has been sent
+
+	// File-backed response body (sendfile() zero-copy mode)
+	int					_fileFd;        // Open fd of the file being streamed (-1 = none)
+	off_t				_fileOffset;    // Current read position in the file
+	size_t				_fileRemaining; // Bytes of the file still to send
 
 	// HTTP Request object
 	Request*			_request;       // Parsed HTTP request (owned by Connection)
+	bool				_pipelinedPartial; // _request holds a half-parsed
+	                                       // pipelined request - keep it
+	                                       // across reset()
+	bool				_chunkStream;   // Chunked response still open -
+	                                    // don't complete on buffer drain
+	size_t				_accountedBytes; // Buffer capacity last reported to
+	                                     // Counters::bufferedBytes (delta
+	                                     // accounting; see updateByteAccounting)
 
 
 	// ===========================
@@ -478,6 +625,40 @@ private:
 	*/
 	bool parseRequest();
 
+	/*
+		updateByteAccounting() - Keep the global buffer gauge current
+
+		Reports the DELTA between this connection's current buffer
+		capacity (read + header + body) and what it last reported,
+		so Counters::bufferedBytes always equals the sum across all
+		connections at O(1) per update. Called wherever a buffer can
+		have grown or shrunk: after reads, after a response is
+		queued, after reset(), and from the destructor (which
+		reports the capacity back as zero).
+	*/
+	void updateByteAccounting();
+
+	/*
+		sendFileData() - Stream the file-backed body with sendfile()
+
+		Called by writeData() once the header bytes in _writeBuffer
+		have gone out. Loops on sendfile() until the file is fully
+		sent or the socket buffer is full (EAGAIN).
+
+		Returns:
+			true if connection should stay open
+			false on error (close connection)
+	*/
+	bool sendFileData();
+
+	/*
+		closeFileBody() - Release the file fd of a file-backed body
+
+		Safe to call when no file is open. Used on completion,
+		reset and destruction.
+	*/
+	void closeFileBody();
+
 	/*
 		determineKeepAlive() - Check if connection should persist
 
@@ -0,0 +1,90 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Counters.hpp                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: anemet <anemet@student.42luxembourg.lu>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/09/01 15:05:00 by anemet            #+#    #+#             */
+/*   Updated: 2026/09/01 15:05:00 by anemet           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef COUNTERS_HPP
+#define COUNTERS_HPP
+
+#include <string>
+#include <ctime>
+
+/*
+	=================================
+		SERVER COUNTERS
+	=================================
+
+	Live observability counters behind the /.webserv/status endpoint.
+
+	Every field is a plain unsigned long bumped with ++ at the event
+	site - the hot path pays one increment, never a syscall, never a
+	lock (the workers are single-threaded; with prefork each worker
+	reports its own numbers, like nginx's per-worker stub_status).
+
+	Derived values (accepts/sec, requests/sec, keep-alive reuse
+	ratio) are computed at RENDER time from the totals and the
+	process start time, so serving the counters costs nothing until
+	someone actually asks.
+
+	Rendered in two formats by the Router's reserved-path handler:
+
+		GET /.webserv/status                     -> JSON
+		GET /.webserv/status?format=prometheus   -> Prometheus text
+
+	All fields are static for the same reason Logger and Stats are:
+	one set per worker process, reachable from Connection and Server
+	without threading a pointer through every call chain.
+*/
+
+class Counters
+{
+	public:
+		// --- Totals (monotonic) ---
+		static unsigned long	accepted;			// accept4() successes
+		static unsigned long	requests;			// Requests routed
+		static unsigned long	bytesIn;			// recv()'d from clients
+		static unsigned long	bytesOut;			// sent to clients
+		static unsigned long	keepAliveReuses;	// Extra requests served on
+													// an already-used connection
+		static unsigned long	timeouts;			// Idle connections reaped
+		static unsigned long	cgiStarted;			// CGI children forked
+
+		// --- Gauges (current state) ---
+		static unsigned long	activeConnections;
+		static unsigned long	cgiActive;			// CGI children in flight
+		static unsigned long	bufferedBytes;		// Sum of all Connection
+													// buffer capacities (what
+													// the memory budget caps)
+
+		// Set once in Server::init() - denominator for the /sec rates
+		static time_t			startTime;
+
+		/*
+			toJson() - One flat JSON object
+
+			Totals, gauges, and the derived rates/ratio. Keys are
+			snake_case to match the config file register.
+		*/
+		static std::string toJson();
+
+		/*
+			toPrometheus() - Prometheus text exposition format
+
+			One "# TYPE" line plus a sample per metric, counter vs
+			gauge marked accordingly, metric names prefixed with
+			"webserv_".
+		*/
+		static std::string toPrometheus();
+
+	private:
+		Counters();	// Static-only class, never instantiated
+};
+
+#endif
@@ -0,0 +1,152 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   FileCache.hpp                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: anemet <anemet@student.42luxembourg.lu>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/09/01 09:10:00 by anemet            #+#    #+#             */
+/*   Updated: 2026/09/01 09:10:00 by anemet           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef FILECACHE_HPP
+# define FILECACHE_HPP
+
+#include <string>
+#include <map>
+#include <ctime>
+#include <sys/types.h>
+
+/*
+	=================================================================
+		FILECACHE CLASS - IN-MEMORY HOT-FILE CACHE
+	=================================================================
+
+	Small static assets (index.html, stylesheets, icons...) are
+	requested thousands of times per second but change almost never.
+	Without a cache, every single GET pays:
+
+		stat() + open() + read() + close()   (4 syscalls + disk I/O)
+
+	The FileCache keeps those files in memory, keyed by their
+	RESOLVED filesystem path. Each entry stores:
+	- The file contents
+	- The MIME type (computed once)
+	- A precomputed ETag and Last-Modified header value
+
+	Freshness (mtime invalidation):
+	-------------------------------
+	We cannot serve stale content forever, but we also don't want a
+	stat() per request (that would defeat the point). The compromise:
+	an entry is trusted for REVALIDATE_INTERVAL_SEC seconds, then the
+	next lookup re-stat()s the file. If size or mtime changed, the
+	entry is dropped and the caller re-reads from disk.
+
+	Eviction (LRU):
+	---------------
+	Entries carry a monotonically increasing "last used" stamp. When
+	the cache grows past MAX_CACHE_BYTES, the least recently used
+	entries are evicted until we're back under budget. With the
+	per-file size cap this is rare in practice - the hot set of a
+	typical site fits comfortably.
+*/
+
+
+/*
+	=================================================================
+		CONSTANTS
+	=================================================================
+*/
+
+// Only files up to this size are cached. Matches the threshold in
+// Router::serveFile(): larger files are streamed with sendfile()
+// from the kernel page cache and gain nothing from a userspace copy.
+static const size_t CACHE_MAX_FILE_SIZE = 64 * 1024;		// 64 KB
+
+// Total memory budget for cached file bodies
+static const size_t CACHE_MAX_TOTAL_BYTES = 8 * 1024 * 1024;	// 8 MB
+
+// How long an entry is trusted before the next lookup re-stat()s it
+static const int CACHE_REVALIDATE_INTERVAL_SEC = 2;
+
+
+/*
+	=================================================================
+		CACHE ENTRY
+	=================================================================
+*/
+struct FileCacheEntry
+{
+	std::string		body;			// File contents
+	std::string		mimeType;		// Content-Type value
+	std::string		etag;			// Precomputed ETag header value
+	std::string		lastModified;	// Precomputed Last-Modified header value
+	time_t			mtime;			// File mtime when cached (for revalidation)
+	time_t			lastValidated;	// When we last stat()ed the file
+	unsigned long	lastUsed;		// LRU stamp (higher = more recent)
+
+	FileCacheEntry() : mtime(0), lastValidated(0), lastUsed(0) {}
+};
+
+
+/*
+	=================================================================
+		FILECACHE CLASS
+	=================================================================
+*/
+class FileCache
+{
+public:
+	FileCache();
+	~FileCache();
+
+	/*
+		get() - Look up a file by resolved path
+
+		Revalidates against the filesystem if the entry is older than
+		CACHE_REVALIDATE_INTERVAL_SEC (drops it when the file changed
+		or disappeared) and bumps the LRU stamp on a hit.
+
+		Returns: Pointer to the entry, or NULL on miss/stale.
+		The pointer is only valid until the next get()/put().
+	*/
+	const FileCacheEntry* get(const std::string& path);
+
+	/*
+		put() - Insert (or refresh) a file in the cache
+
+		Oversized files are silently ignored. Evicts LRU entries if
+		the memory budget is exceeded.
+
+		Parameters:
+			path:     Resolved filesystem path (cache key)
+			body:     File contents
+			mimeType: Content-Type for the file
+			mtime:    File modification time at read
+	*/
+	void put(const std::string& path, const std::string& body,
+			 const std::string& mimeType, time_t mtime);
+
+	/*
+		clear() - Drop all entries (e.g. on config reload)
+	*/
+	void clear();
+
+	// Current number of cached files / total cached body bytes
+	size_t getEntryCount() const;
+	size_t getTotalBytes() const;
+
+private:
+	std::map<std::string, FileCacheEntry>	_entries;		// path -> entry
+	size_t									_totalBytes;	// Sum of body sizes
+	unsigned long							_useCounter;	// LRU clock
+
+	/*
+		evictIfNeeded() - Evict least recently used entries until the
+		total body bytes fit within CACHE_MAX_TOTAL_BYTES.
+	*/
+	void evictIfNeeded();
+};
+
+#endif // FILECACHE_HPP
@@ -0,0 +1,118 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   HeaderMap.hpp                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: anemet <anemet@student.42luxembourg.lu>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/09/01 10:12:00 by anemet            #+#    #+#             */
+/*   Updated: 2026/09/01 10:12:00 by anemet           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef HEADERMAP_HPP
+#define HEADERMAP_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+/*
+	=================================
+		HEADERMAP CLASS
+	=================================
+
+	Case-insensitive HTTP header container shared by Request and Response.
+
+	HTTP header names are case-insensitive (RFC 7230): "Content-Type",
+	"content-type" and "CONTENT-TYPE" are the same header. The old
+	approach - std::map plus a Utils::toLower() / std::transform on
+	EVERY lookup - allocated a fresh lowered string per access, and
+	Request::getHeader() even lowered every stored key again while
+	scanning. Header access sits right behind raw I/O in our profiles,
+	so those throwaway strings were pure overhead.
+
+	HeaderMap fixes the cost model at the container level:
+
+	- Lookups compare names character by character, case-insensitively,
+	  with NO temporary string (see equalsNoCase()).
+
+	- Standard header names ("Host", "Content-Length", ...) are interned
+	  once at insert: the entry shares the canonical spelling instead of
+	  copying whatever casing the client happened to send. This also
+	  normalizes the wire casing of response headers for free.
+
+	- Entries live in a flat std::vector in insertion order. A request
+	  or response carries ~10 headers, so a linear scan with a cheap
+	  comparator beats a balanced tree plus allocations; C++98 has no
+	  std::unordered_map, and a hand-rolled hash table would be
+	  overkill at this element count.
+
+	Duplicate names overwrite (last value wins), matching what the old
+	std::map storage did.
+*/
+
+class HeaderMap
+{
+	public:
+		// One header: (name, value). Name keeps its canonical/interned
+		// spelling; matching against it is always case-insensitive.
+		typedef std::pair<std::string, std::string>		Entry;
+		typedef std::vector<Entry>::const_iterator		const_iterator;
+
+		// ================================
+		//  Constructors & Destructor
+		// ================================
+		HeaderMap();
+		~HeaderMap();
+		HeaderMap(const HeaderMap& other);
+		HeaderMap& operator=(const HeaderMap& other);
+
+		/*
+			set() - Insert or replace a header
+
+			The stored name is the interned standard spelling when one
+			matches (e.g. "content-length" -> "Content-Length"), else
+			the name exactly as given. Replacing keeps the entry's
+			original position.
+		*/
+		void set(const std::string& name, const std::string& value);
+
+		/*
+			get() - Case-insensitive lookup
+
+			Returns a reference to the stored value, or to a shared
+			empty string when the header is absent - no copy, no
+			temporary lowered name.
+		*/
+		const std::string& get(const std::string& name) const;
+
+		bool has(const std::string& name) const;
+		void remove(const std::string& name);
+		void clear();
+		bool empty() const;
+		size_t size() const;
+
+		// Iteration in insertion order (serialization, CGI env vars)
+		const_iterator begin() const;
+		const_iterator end() const;
+
+		/*
+			equalsNoCase() - Allocation-free case-insensitive compare
+
+			The building block for every lookup: length check first,
+			then a per-character ASCII tolower comparison.
+		*/
+		static bool equalsNoCase(const std::string& a, const std::string& b);
+
+	private:
+		std::vector<Entry> _entries;
+
+		// Index of the entry matching `name`, or -1
+		long findIndex(const std::string& name) const;
+
+		// Canonical spelling for a standard header name, or NULL
+		static const std::string* internName(const std::string& name);
+};
+
+#endif
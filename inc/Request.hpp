@@ -20,6 +20,26 @@
 #include <cstdlib>
 #include <sstream>
 
+#include "HeaderMap.hpp"
+
+/*
+	Body spill threshold.
+
+	Bodies up to this size are accumulated in _body (std::string) as
+	before. At or above it, the parser streams body bytes into a temp
+	file as they arrive, keeping per-connection memory flat no matter
+	how large the upload is - a handful of concurrent 1 GB uploads
+	used to mean a handful of 1 GB strings.
+
+	1 MB matches the old hard in-memory limit, so anything that was
+	previously held in memory still is.
+*/
+static const size_t BODY_SPILL_THRESHOLD = 1048576;	// 1 MB
+
+// Absolute body cap (spilled bodies included) - same value the
+// chunked decoder has always enforced
+static const size_t MAX_BODY_SIZE = 104857600;		// 100 MB
+
 class Request
 {
 	public:
@@ -42,6 +62,18 @@ class Request
 		// Feed raw data to the parser, returns true when request is complete
 		bool parse(const std::string& data);
 
+		/*
+			takeLeftover() - Steal bytes buffered beyond this request
+
+			With HTTP/1.1 pipelining the client may send request #2
+			(and #3...) in the same TCP segments as request #1. Those
+			extra bytes end up in _buffer after this request reaches
+			PARSE_COMPLETE. The Connection takes them here (O(1) swap),
+			resets the Request, and re-feeds them to parse the next
+			pipelined request without waiting for the network.
+		*/
+		void takeLeftover(std::string& out);
+
 		// Reset for reuse (keep-alive connections)
 		void reset();
 
@@ -53,9 +85,34 @@ class Request
 		const std::string& getHttpVersion() const;
 		const std::string& getBody() const;
 
-		// Header access (case-insensitive)
-		std::string getHeader(const std::string& name) const;
-		const std::map<std::string, std::string>& getHeaders() const;
+		// Header access (case-insensitive, allocation-free - see HeaderMap)
+		const std::string& getHeader(const std::string& name) const;
+		const HeaderMap& getHeaders() const;
+
+		// Outcome of parsing the Range header against a file size
+		enum RangeResult
+		{
+			RANGE_NONE,				// No Range header / malformed / multi-range
+									// (RFC 7233 lets us ignore and serve 200)
+			RANGE_VALID,			// Single satisfiable range -> serve 206
+			RANGE_UNSATISFIABLE		// Range present but outside the file -> 416
+		};
+
+		/*
+			getByteRange() - Parse the Range header for a single byte range
+
+			Supports the three RFC 7233 forms, resolved against fileSize:
+
+				bytes=100-199   explicit range (end clamped to EOF)
+				bytes=100-      from offset to EOF
+				bytes=-200      last 200 bytes (suffix range)
+
+			Multi-range requests (commas) would need multipart/byteranges
+			framing; we ignore them and serve the full file, which the
+			RFC explicitly allows. On RANGE_VALID, offset/length describe
+			the slice to serve.
+		*/
+		RangeResult getByteRange(size_t fileSize, size_t& offset, size_t& length) const;
 
 		// State queries
 		ParseState getState() const;
@@ -67,6 +124,20 @@ class Request
 		size_t getContentLength() const;
 		size_t getBodySize() const;
 
+		/*
+			Spilled-body access.
+
+			isBodyInFile() tells whether the body was streamed to disk
+			(size >= BODY_SPILL_THRESHOLD). When it returns true,
+			getBody() is empty and the bytes live in the temp file at
+			getBodyFilePath(). Consumers either stream from that file
+			(CGI stdin) or rename() it into place (uploads) - the
+			temp file is unlinked on reset()/destruction, which is a
+			harmless ENOENT after a rename.
+		*/
+		bool isBodyInFile() const;
+		const std::string& getBodyFilePath() const;
+
 		// Client IP (set by Connectioin/Server for CGI use)
 		void setClientIP(const std::string& ip);
 		const std::string& getClientIP() const;
@@ -78,18 +149,59 @@ class Request
 		std::string _queryString;
 		std::string _httpVersion;
 		std::string _body;
-		std::map<std::string, std::string> _headers;
+		HeaderMap _headers;
 		std::string _clientIP; // Client's IP address for CGI
 
 		ParseState _state;
 		int _errorCode;
 		std::string _buffer;
+		size_t _parsePos;	// Bytes of _buffer already consumed (see parse())
 		size_t _contentLength;
 		size_t _bodyBytesRead;
 		size_t _expectedChunkSize;  // 0 = reading size line, >0 = reading chunk data
+
+		// Spill-to-disk state (bodies >= BODY_SPILL_THRESHOLD)
+		bool _bodyInFile;			// True once the body lives on disk
+		std::string _bodyFilePath;	// Temp file holding the body bytes
+		int _bodyFd;				// Open write fd while still parsing
+
 		bool parseRequestLine(const std::string& line);
 		bool parseHeader(const std::string& line);
 		bool parseChunkedBody();
+
+		/*
+			normalizePath() - Canonicalize _path in a single scan
+
+			Percent-decodes, collapses "." / ".." segments (clamped at
+			the root), merges duplicate slashes and validates the
+			bytes (no control characters, well-formed UTF-8) in one
+			pass over the path. Every later consumer - location
+			matching, filesystem resolution, CGI SCRIPT_NAME and
+			PATH_INFO - reuses the result instead of re-scanning the
+			URI. Returns false on a malformed path (caller sends 400).
+		*/
+		bool normalizePath();
+
+		/*
+			spillBodyToFile() - Switch the body from memory to disk
+
+			Creates the temp file (mkstemp), flushes whatever is
+			already in _body into it and clears _body. Returns false
+			if the file can't be created (caller falls back to 500).
+		*/
+		bool spillBodyToFile();
+
+		/*
+			appendBodyBytes() - Append body data, spilling when needed
+
+			Single entry point used by both the Content-Length and
+			chunked paths. Streams to the temp file once the total
+			crosses BODY_SPILL_THRESHOLD, appends to _body below it.
+		*/
+		bool appendBodyBytes(const char* data, size_t len);
+
+		// Close the write fd / unlink the temp file (reset, dtor)
+		void discardBodyFile();
 };
 
 #endif
@@ -20,6 +20,8 @@
 #include <cstring>
 #include <fstream>
 
+#include "HeaderMap.hpp"
+
 /*
 	=================================
 		HTTP RESPONSE BASICS
@@ -60,12 +62,20 @@ class Response
 	private:
 		int _statusCode;								// HTTP status code (200, 404, 500, etc.)
 		std::string _reasonPhrase;						// Human-readable status ("OK", "Not Found")
-		std::map<std::string, std::string> _headers;	// HTTP headers (key -> value)
+		HeaderMap _headers;								// HTTP headers (case-insensitive)
 		std::string _body;								// Response body content
-		mutable std::string _builtResponse;				// Cached complete HTTP response string
-		mutable bool _dirty;							// Flag: does response need rebuilding?
+		mutable std::string _builtHeaders;				// Cached status line + headers (+ blank line)
+		mutable bool _dirty;							// Flag: does header block need rebuilding?
 		bool _keepAlive;								// Should connection stay open?
 
+		bool _chunked;									// Transfer-Encoding: chunked mode
+
+		// File-backed body (zero-copy mode, see setFileBody())
+		bool _fileBody;									// Body comes from a file, not _body
+		std::string _filePath;							// Path of the file to stream
+		size_t _fileOffset;								// First byte of the file to send
+		size_t _fileLength;								// Number of bytes to send
+
 		// Lazy building pattern - only rebuild when needed
 		void buildIfNeeded() const;
 
@@ -84,6 +94,37 @@ class Response
 		void setBody(const std::string& body);
 		void setBody(const char* data, size_t length);
 
+		/*
+			setFileBody() - File-backed body for zero-copy serving
+
+			Instead of reading a (possibly huge) file into _body, the
+			Response only records WHERE the body lives on disk. The
+			Connection then streams it straight from the kernel page
+			cache with sendfile() - no userspace copies at all.
+
+			build() produces only the status line + headers in this
+			mode; Content-Length is derived from `length`.
+		*/
+		void setFileBody(const std::string& path, size_t offset, size_t length);
+
+		/*
+			setChunked() - Switch to Transfer-Encoding: chunked
+
+			For bodies whose length isn't known up front (streamed CGI
+			output). The header block advertises chunked encoding and
+			carries NO Content-Length; the Connection frames body
+			fragments with Connection::appendChunk() as they arrive and
+			terminates the stream with endChunkStream().
+		*/
+		void setChunked();
+		bool isChunked() const;
+
+		// File-backed body accessors (used by Connection::writeData())
+		bool hasFileBody() const;
+		const std::string& getFilePath() const;
+		size_t getFileOffset() const;
+		size_t getFileLength() const;
+
 		// ===== Convenience methods for common headers =====
 		void setContentType(const std::string& type);
 		void setContentLength(size_t length);
@@ -96,14 +137,34 @@ class Response
 
 		// ===== Building the response =====
 		std::string build() const;			// Build the complete HTTP response string
-		const std::string& getData() const;	// Get raw response data for sending
 		size_t getSize() const;
 
+		/*
+			getHeaderData() - The serialized header block only
+
+			Status line + headers + terminating blank line, WITHOUT the
+			body appended. The Connection sends this and the body as two
+			separate iovecs with writev(), so a 10 MB body is never
+			concatenated behind ~200 bytes of headers just to go out in
+			one buffer.
+		*/
+		const std::string& getHeaderData() const;
+
+		/*
+			swapBody() - Steal the body without copying it
+
+			Swaps _body with `out` (O(1) pointer exchange). Builds the
+			header block first so Content-Length still reflects the real
+			body size. After this call the Response is hollow - only the
+			Connection's buffers own the data.
+		*/
+		void swapBody(std::string& out);
+
 		// ===== Getters =====
 		int getStatusCode() const;
 		const std::string& getBody() const;
 		const std::string& getReasonPhraseValue() const;
-		std::string getHeader(const std::string& name) const;
+		const std::string& getHeader(const std::string& name) const;
 		bool hasHeader(const std::string& name) const;
 		bool shouldKeepAlive() const;
 
@@ -21,6 +21,8 @@
 
 #include "Request.hpp"
 #include "Response.hpp"
+#include "FileCache.hpp"
+#include "CGI.hpp"
 
 // Forward declarations
 class Config;
@@ -61,6 +63,72 @@ class Router
 		// Set/update configuration
 		void setConfig(const Config& config);
 
+		/*
+			getConfigGeneration() - Version stamp of the active config
+
+			Bumped every setConfig() call. Lets per-connection caches
+			of config-derived pointers (the Connection's Host ->
+			ServerConfig memo) detect a SIGHUP reload and re-resolve
+			instead of routing keep-alive requests with stale blocks.
+		*/
+		unsigned long getConfigGeneration() const;
+
+		/*
+			prewarmCaches() - Pay the cold-start costs before traffic
+
+			Called once after setConfig() at startup (and after a
+			SIGHUP reload): reads every location's index file into the
+			hot-file cache and faults the first pages of each CGI
+			interpreter binary into the page cache. Error pages are
+			already pre-read by buildRouteIndex(). The first request
+			after a deploy then takes the same path as the millionth -
+			no first-hit stat()/open()/read() spike.
+		*/
+		void prewarmCaches();
+
+		/*
+			CgiExecution - Handoff from Router to Server for async CGI
+
+			When the caller passes a CgiExecution* to route() and the
+			request turns out to be CGI, the Router launches the child
+			via CGI::startAsync() instead of running it synchronously.
+			It fills this struct with everything the Server needs to
+			drive the child from its epoll loop:
+
+				pid      - child process (to kill/reap)
+				stdinFd  - write end: feed the request body here
+				stdoutFd - read end:  CGI output arrives here
+				body     - the request body to write to stdinFd
+
+			'started' tells the caller whether the handoff happened.
+			If it's false, the Response returned by route() is final
+			(static file, redirect, error, or a synchronous fallback).
+		*/
+		struct CgiExecution
+		{
+			bool		started;	// True if a CGI child was launched
+			bool		deferred;	// True if the worker cap was reached
+			int			activeCount;// IN: caller's current CGI child count
+			pid_t		pid;		// Child process id
+			int			stdinFd;	// Non-blocking write end for the body
+			int			stdoutFd;	// Non-blocking read end for output
+			std::string	body;		// Request body to feed to stdin
+			std::string	bodyFile;	// Spilled body: stream this file
+									// to stdin instead (body is empty)
+			size_t		maxOutput;	// Location's cgi_max_output cap
+									// (0 = unlimited)
+
+			CgiExecution() :
+				started(false),
+				deferred(false),
+				activeCount(0),
+				pid(-1),
+				stdinFd(-1),
+				stdoutFd(-1),
+				maxOutput(0)
+			{}
+		};
+
 		/*
 			route() - Main entry point for request handling
 
@@ -71,20 +139,94 @@ class Router
 			Parameters:
 				request:    Parsed HTTP request
 				serverPort: The port this request came in on
+				asyncCgi:   If non-NULL and the request is CGI, launch
+				            the child asynchronously and fill this in
+				            (the returned Response is then a placeholder)
+				vhost:      Pre-resolved server block for this request
+				            (the Connection's Host memo), or NULL to
+				            resolve from the Host header here
 
 			Returns:
-				Complete HTTP Response ready to send
+				Complete HTTP Response ready to send (unless asyncCgi->started)
+		*/
+		Response route(const Request& request, int serverPort,
+						CgiExecution* asyncCgi = NULL,
+						const ServerConfig* vhost = NULL);
+
+		/*
+			finishCgi() - Build the final Response from captured CGI output
+
+			Called by the Server once an async CGI child has exited and
+			its complete stdout has been collected from the epoll loop.
+			Parses the output (headers + body) and builds the Response
+			exactly like the synchronous path does.
 		*/
-		Response route(const Request& request, int serverPort);
+		Response finishCgi(const std::string& rawOutput);
+
+		/*
+			startCgiStream() - Begin a chunked response from CGI headers
+
+			Called by the Server as soon as the script's header block
+			(everything up to and including the blank line) has arrived,
+			while the script is still producing its body. Returns a
+			chunked-mode Response carrying the script's status and
+			headers; the Server then frames body fragments with
+			Connection::appendChunk() as they come off the pipe.
+
+			Returns a NON-chunked placeholder if the header block can't
+			be parsed - the caller falls back to buffering the whole
+			output and the EOF path produces the 502.
+		*/
+		Response startCgiStream(const std::string& headerBlock);
+
+		/*
+			findServer() - Find the server block for (port, Host)
+
+			Index lookup into the precompiled server table; the entry
+			with an empty name is the port's default server. Public so
+			the Server can resolve once per connection and memoize the
+			result (see Connection::cacheVhost()) instead of paying
+			the lookup on every keep-alive request.
+		*/
+		const ServerConfig* findServer(int port, const std::string& hostname = "") const;
 
 private:
 	// ================================
 	//  Server/Location Finding
 	// ================================
-	const ServerConfig* findServer(int port, const std::string& hostname = "") const;
 	const LocationConfig* findLocation(const ServerConfig& server,
 										const std::string& path) const;
 
+	/*
+		RouteNode - One node of the per-server location prefix tree
+
+		Locations are inserted segment by segment ("/api/users" ->
+		"api" -> "users"); a node carries a LocationConfig* when a
+		location block ends exactly there. Matching walks the request
+		path's segments and remembers the deepest node that carries a
+		location - longest-prefix-match in O(path length), independent
+		of how many location blocks the config has.
+	*/
+	struct RouteNode
+	{
+		std::map<std::string, RouteNode*>	children;	// Segment -> subtree
+		const LocationConfig*				location;	// Block ending here (or NULL)
+
+		RouteNode() : location(NULL) {}
+	};
+
+	/*
+		buildRouteIndex() - Precompile the routing tables
+
+		Called from setConfig() (and the constructors/copies): builds
+		the (port, server_name) -> ServerConfig index and one location
+		prefix tree per server block, so route() never scans the raw
+		config vectors again.
+	*/
+	void buildRouteIndex();
+	void clearRouteIndex();
+	static void freeRouteNode(RouteNode* node);
+
 	// ================================
 	//  Path Resolution
 	// ================================
@@ -96,16 +238,85 @@ private:
 	//  Request Handlers
 	// ================================
 	Response handleGet(const Request& request, const LocationConfig& location);
+
+	/*
+		tryPrecompressed() - Serve a sibling .gz file for hot assets
+
+		With 'gzip on', a GET for /app.js first looks for /app.js.gz
+		on disk. If present it is served as-is with Content-Encoding:
+		gzip and the ORIGINAL file's MIME type - precompressed assets
+		cost zero CPU per request. Returns false when there is no .gz
+		sibling (or the client doesn't accept gzip).
+	*/
+	bool tryPrecompressed(const Request& request, const std::string& path,
+							const LocationConfig& location, Response& response);
+
+	/*
+		maybeCompress() - Gzip an eligible response body in place
+
+		Applied on the way out of route() for in-memory bodies when
+		the location has 'gzip on' and the client sent
+		Accept-Encoding: gzip. Only text-like MIME types above a
+		minimum size are worth the CPU; file-backed (sendfile) and
+		chunked responses are left alone.
+	*/
+	void maybeCompress(const Request& request, const LocationConfig& location,
+						Response& response);
+
+	/*
+		acceptsGzip() - Does the request allow gzip encoding?
+	*/
+	bool acceptsGzip(const Request& request) const;
 	Response handlePost(const Request& request, const LocationConfig& location);
 	Response handleDelete(const Request& request, const LocationConfig& location);
 	Response handleCgi(const Request& request, const std::string& scriptPath,
-						const LocationConfig& location);
+						const LocationConfig& location,
+						CgiExecution* asyncCgi = NULL);
+
+	/*
+		cgiResultToResponse() - Shared CGIResult -> Response conversion
+
+		Used by both the synchronous path (handleCgi) and the async
+		path (finishCgi) so error pages and header handling stay
+		identical regardless of how the script was executed.
+	*/
+	Response cgiResultToResponse(const CGI::CGIResult& result);
 
 	// ================================
 	//  File/Directory Serving
 	// ================================
-	Response serveFile(const std::string& filepath);
-	Response serveDirectory(const std::string& dirpath, const LocationConfig& location);
+	/*
+		serveFile() - Serve a static file, honoring validators and ranges
+
+		When a request is supplied it drives the conditional / partial
+		logic (NULL skips it - used by the precompressed .gz path,
+		whose validators would describe the wrong representation):
+
+		- ETag ("size-mtime" in hex, same recipe as the file cache)
+		  and Last-Modified are emitted on every response.
+		- If-None-Match (or If-Modified-Since when no ETag was sent)
+		  matching the current file short-circuits to an empty 304 -
+		  the bytes never leave the disk.
+		- A single satisfiable Range produces 206 + Content-Range;
+		  big files slice via the sendfile() offset, cached/small
+		  files via substr. An unsatisfiable range gets 416.
+	*/
+	Response serveFile(const std::string& filepath, const Request* request);
+	Response serveDirectory(const std::string& dirpath, const LocationConfig& location,
+							const Request* request);
+
+	/*
+		notModified() - Does the request's cache state match the file?
+
+		If-None-Match wins over If-Modified-Since (RFC 7232). ETags are
+		compared after stripping any W/ weak prefix; "*" matches any
+		entity. If-Modified-Since is compared as an exact string against
+		our own Last-Modified output - clients echo the validator back
+		verbatim, so equality is the match that matters and no date
+		parsing is needed.
+	*/
+	static bool notModified(const Request& request, const std::string& etag,
+							const std::string& lastModified);
 
 	// ================================
 	//  Directory Listing Helpers (Step 9.2)
@@ -138,10 +349,73 @@ private:
 	// ================================
 	Response errorResponse(int code, const ServerConfig* server = NULL);
 
+	/*
+		statusResponse() - The reserved /.webserv/status endpoint
+
+		Renders the live Counters as JSON (default) or Prometheus
+		text (?format=prometheus). GET only.
+	*/
+	Response statusResponse(const Request& request);
+
 	// ================================
 	//  Member Variables
 	// ================================
 	const Config* _config;
+
+	// Bumped on every setConfig() - see getConfigGeneration()
+	unsigned long _configGeneration;
+
+	/*
+		Precompiled routing tables (built by buildRouteIndex()).
+
+		_serverIndex maps (port, server_name) to its server block;
+		the entry with an empty name is the port's default server.
+		_routeTrees holds one location prefix tree per server block.
+		Both hold pointers into the Config, which outlives the Router.
+	*/
+	std::map<std::pair<int, std::string>, const ServerConfig*>	_serverIndex;
+	std::map<const ServerConfig*, RouteNode*>					_routeTrees;
+
+	/*
+		Custom error-page bodies, read from disk ONCE when the route
+		index is built. Keyed by the configured file path. A 404
+		storm (crawlers probing dead links) used to pay an open() +
+		read() per error response; now it's a map lookup. Pages
+		whose file can't be read at startup simply aren't cached and
+		fall back to the built-in error page at request time.
+	*/
+	std::map<std::string, std::string>							_errorPageCache;
+
+	/*
+		Autoindex listing cache, keyed by directory path.
+
+		Generating a listing opendir()s and stat()s EVERY entry - for
+		a 50k-file download directory that is ~300 ms of syscalls per
+		hit, on the event loop. The finished HTML is cached with the
+		directory's mtime; entries are validated by one stat() per
+		hit and regenerated only when the directory itself changed
+		(files added/removed/renamed bump a directory's mtime).
+
+		Known limit of the key: rewriting a contained file in place
+		does not touch the directory mtime, so sizes/dates in a
+		cached listing can lag until the directory next changes.
+	*/
+	struct AutoindexEntry
+	{
+		time_t		mtime;	// Directory mtime the HTML was built from
+		std::string	html;	// The finished listing page
+	};
+	std::map<std::string, AutoindexEntry>						_autoindexCache;
+	size_t														_autoindexCacheBytes;
+
+	/*
+		Hot-file cache for small static assets.
+
+		Only useful because the Server keeps ONE Router alive across
+		requests - a per-request Router would start cold every time.
+		Keyed by resolved filesystem path; see FileCache.hpp.
+	*/
+	FileCache _fileCache;
 };
 
 #endif
@@ -70,6 +70,7 @@
 
 #include "Config.hpp"
 #include "Connection.hpp"
+#include "Router.hpp"
 
 // Standard C/C++ headers
 #include <iostream>		// std::cout, std::cerr for logging
@@ -77,15 +78,19 @@
 #include <cerrno>		// errno for error codes
 #include <cstdlib>		// exit()
 #include <ctime>		// time() for connection timestamps
+#include <fstream>		// std::ifstream for /proc/net/netstat counters
+#include <sstream>		// parsing the TcpExt counter lines
 
 // POSIX/System headers for networking
 #include <sys/socket.h>	// socket(), bind(), listen(), accept(), setsockopt(), SO_REUSEPORT
 #include <sys/types.h>	// Various type definitions
 #include <netinet/in.h>	// struct sockaddr_in, INADDR_ANY, htons()
 #include <arpa/inet.h>	// inet_pton(), inet_ntoa() for IP address conversion
-#include <unistd.h>		// close(), fcntl()
+#include <unistd.h>		// close(), fcntl(), fork()
 #include <fcntl.h>		// fcntl(), O_NONBLOCK
 #include <sys/epoll.h>	// epoll_create1(), epoll_ctl(), epoll_wait()
+#include <sys/wait.h>	// waitpid() for reaping worker processes
+#include <signal.h>		// kill(), SIGTERM for worker shutdown
 
 
 /*
@@ -114,8 +119,35 @@
 		- More efficient but tricky to use correctly
 		- Must drain all data or you'll miss events!
 
-	We'll use level-triggered for simplicity and safety.
+	We use edge-triggered mode for CLIENT sockets: Connection's
+	readData()/writeData() loop on recv()/send() until EAGAIN, so
+	we never miss an edge, and we save one epoll_wait() wakeup per
+	partial read on keep-alive heavy workloads.
+
+	Listening sockets stay level-triggered: accept() is cheap and
+	level-triggered simply re-notifies while connections are queued.
+*/
+
+
+/*
+	Epoll trigger mode for client sockets.
+
+	EPOLLET requires the drain-until-EAGAIN loops implemented in
+	Connection::readData()/writeData(). Set to 0 to fall back to
+	level-triggered mode when debugging event-loop issues.
+
+	With EPOLLET each client is armed exactly once, with
+	EPOLLIN|EPOLLOUT, at accept time. Read/write interest is tracked
+	purely in userspace (Connection state) instead of flipping the
+	epoll mask on every request/response transition - that cost two
+	epoll_ctl() syscalls per keep-alive request. The price is that
+	queueing a response does not generate an event by itself (the
+	socket was writable all along, and edges only fire on
+	transitions), so every path that parks bytes on a connection's
+	write buffers must start the send itself - see
+	Server::flushClientWrites().
 */
+static const uint32_t CLIENT_TRIGGER_MODE = EPOLLET;
 
 
 /*
@@ -141,6 +173,76 @@ static const int EPOLL_TIMEOUT_MS = 1000;  // 1 second
 	static const int CONNECTION_TIMEOUT_SEC = 60;   // 1 minute
 #endif
 
+/*
+	Phase timeouts (Slowloris defense).
+
+	The single idle timeout above is what keep-alive connections get
+	BETWEEN requests. A client that is mid-request is held to much
+	tighter deadlines, because "slow" there is the attack: trickling
+	one header byte per 50 seconds resets an idle timer forever while
+	pinning a Connection, its buffers and an epoll slot.
+
+	- HEADER_TIMEOUT_SEC: the request line + headers must be complete
+	  this many seconds after the request's first byte (and a freshly
+	  accepted connection must START talking within it). Absolute, not
+	  idle-based - trickled bytes don't extend it.
+	- BODY_TIMEOUT_SEC: max gap between body reads. Idle-based, so a
+	  legitimately slow large upload survives as long as bytes keep
+	  arriving.
+
+	See Connection::getTimeoutDeadline() for the phase selection.
+*/
+static const int HEADER_TIMEOUT_SEC = 10;
+static const int BODY_TIMEOUT_SEC = 30;
+
+/*
+	Per-source-IP concurrent connection cap.
+
+	One misbehaving IP must not be able to fill the fd table and the
+	epoll set for everyone else. 64 parallel connections is far more
+	than any browser opens (6-8 per host); past it, accept4() closes
+	the socket immediately - cheapest possible rejection, no
+	Connection object, no epoll registration.
+*/
+static const int MAX_CONNS_PER_IP = 64;
+
+// Async CGI timeout in seconds - scripts running longer than this are
+// killed and the client gets a 504 (checked in the periodic cleanup)
+static const int CGI_TIMEOUT_SEC = 30;
+
+/*
+	CGI output bounds.
+
+	CGI_MAX_HEADER_SIZE caps how much output we buffer while waiting
+	for the script's header/body separator - a script that emits 16 KB
+	without a blank line is not speaking CGI, and without the cap its
+	"headers" would be buffered without limit.
+
+	CGI_STREAM_BACKPRESSURE_BYTES bounds the client write buffer during
+	chunked streaming: when the client can't drain fast enough, we stop
+	reading the script's stdout. The 64 KB pipe fills, the script
+	blocks in write(), and memory stays flat no matter how much output
+	it wants to produce. Reads resume when the client catches up.
+*/
+static const size_t CGI_MAX_HEADER_SIZE = 16 * 1024;
+static const size_t CGI_STREAM_BACKPRESSURE_BYTES = 256 * 1024;
+
+/*
+	Timer wheel size (seconds per revolution).
+
+	Connection timeouts are tracked in a hashed timer wheel: one slot
+	per second, slot index = expiry_time % TIMER_WHEEL_SIZE. Each tick
+	only the slots between the previous tick and "now" are touched, so
+	expiry processing is O(slots elapsed + entries due) instead of a
+	full scan of every connection.
+
+	Power of two so the modulo compiles to a mask. 128 covers the 60 s
+	production timeout in a single revolution; longer timeouts (DEBUG
+	builds use 2 h) simply re-hash entries once per revolution, which
+	is the standard lazy-cascade behaviour of a hashed wheel.
+*/
+static const int TIMER_WHEEL_SIZE = 128;
+
 /*
 	=================================================================
 		SOCKET INFORMATION STRUCTURE
@@ -166,31 +268,57 @@ struct ListenSocket
 
 /*
 	=================================================================
-		CLIENT CONNECTION INFO (for tracking connected clients)
+		ACTIVE CGI EXECUTION (async, epoll-driven)
 	=================================================================
 
-	We need to track information about each connected client:
-	- File descriptor for communication
-	- Connection timestamp for timeout handling
-	- Server port they connected to (for routing)
-	- Client address for logging
+	One instance per in-flight CGI request. The Router forks the
+	child (CGI::startAsync()) and hands us the pipe fds; from then
+	on the Server treats them like any other non-blocking fd in the
+	epoll loop:
+
+		stdinFd  (EPOLLOUT): write 'input' incrementally, close on
+		                     completion so the script sees EOF
+		stdoutFd (EPOLLIN):  append to 'output' until the pipe hits
+		                     EOF (script exited / closed stdout)
+
+	On stdout EOF the child is reaped (waitpid WNOHANG), the output
+	is parsed by Router::finishCgi(), and the parked client
+	connection (state CONN_CGI_WAIT) gets its Response.
+
+	Heap-allocated and referenced from _cgiPipes under BOTH pipe fds,
+	so an event on either fd finds the same execution state.
 */
-struct ClientInfo
+struct ActiveCgi
 {
-	int				fd;				// Client socket file descriptor
-	time_t			connectTime;	// When connection was established
-	time_t			lastActivity;	// Last read/write activity
-	int				serverPort;		// Which server port they connected to
-	std::string		clientIP;		// Client's IP address (for logging)
-	int				clientPort;		// Client's port (for logging)
-
-	ClientInfo() :
-		fd(-1),
-		connectTime(0),
-		lastActivity(0),
-		serverPort(0),
-		clientIP(""),
-		clientPort(0)
+	pid_t		pid;			// CGI child process
+	int			stdinFd;		// Write end (-1 once body fully fed)
+	int			stdoutFd;		// Read end (-1 once EOF seen)
+	int			clientFd;		// Parked client connection
+	std::string	input;			// Request body chunk to feed to stdin
+	size_t		inputOffset;	// How much of 'input' is written
+	int			inputFd;		// Spilled body: file 'input' refills from
+	std::string	output;			// CGI stdout collected so far
+	time_t		startTime;		// For the CGI_TIMEOUT_SEC check
+	unsigned long startUs;		// Fork timestamp for the cgi histogram
+	bool		streaming;		// Headers sent - output goes straight
+								// to the client as chunked frames
+	size_t		maxOutput;		// cgi_max_output cap (0 = unlimited)
+	size_t		outputBytes;	// Total bytes the script has produced
+	bool		readPaused;		// stdout reads paused (backpressure)
+
+	ActiveCgi() :
+		pid(-1),
+		stdinFd(-1),
+		stdoutFd(-1),
+		clientFd(-1),
+		inputOffset(0),
+		inputFd(-1),
+		startTime(0),
+		startUs(0),
+		streaming(false),
+		maxOutput(0),
+		outputBytes(0),
+		readPaused(false)
 	{}
 };
 
@@ -223,6 +351,16 @@ public:
 	// stop() - Gracefully shut down the server
 	void stop();
 
+	/*
+		requestReload() - Ask for a config reload (SIGHUP)
+
+		Called from the signal handler, so it only sets a flag - the
+		actual parse and swap happen in run(), off the signal path
+		(parsing a file is nowhere near async-signal-safe). See
+		performConfigReload().
+	*/
+	void requestReload();
+
 	// =====================
 	//  Getters
 	// =====================
@@ -240,6 +378,18 @@ public:
 	int getEpollFd() const;
 	size_t getClientCount() const;
 
+	// =====================
+	//  Worker Processes
+	// =====================
+
+	/*
+		getWorkerId() - Which worker process we are
+
+		0 is the master (and only worker in single-process mode),
+		1..N-1 are the preforked children.
+	*/
+	int getWorkerId() const;
+
 
 private:
 	// =====================
@@ -256,6 +406,39 @@ private:
 	void closeAllSockets();
 
 
+	// =====================
+	//  Worker Processes (SO_REUSEPORT prefork mode)
+	// =====================
+
+	/*
+		spawnWorkers() - Prefork worker processes
+
+		Called by init() BEFORE the listening sockets are created, so that
+		every worker binds its OWN set of listening sockets. Because all
+		sockets are bound with SO_REUSEPORT, the kernel hashes incoming
+		connections across the workers' accept queues - load balancing
+		with no shared state and no locks between processes.
+
+		Each worker then runs a completely independent epoll loop:
+		separate _epollFd, separate connection table, zero coordination.
+
+		Parameters:
+			count: Total number of workers (including the master process)
+
+		Returns: true on success, false if fork() failed
+	*/
+	bool spawnWorkers(int count);
+
+	/*
+		reapWorkers() - Terminate and reap worker children
+
+		Called from stop() in the master process only. Sends SIGTERM to
+		every child (their own signal handlers run the same graceful
+		shutdown path), then waitpid()s each one to avoid zombies.
+	*/
+	void reapWorkers();
+
+
 	// =====================
 	//  Epoll Management
 	// =====================
@@ -312,17 +495,35 @@ private:
 	// =====================
 
 	/*
-		acceptNewConnection() - Accept a new client connection
+		acceptNewConnection() - Drain the listen socket's accept queue
 
-		Called when a listening socket has EPOLLIN event.
+		Called when a listening socket has EPOLLIN event. Loops
+		accept4(SOCK_NONBLOCK) until EAGAIN so a burst of arrivals is
+		drained in ONE epoll wakeup, and the socket comes back
+		non-blocking without the two fcntl() calls accept()+fcntl
+		used to cost per connection.
 
 		Parameters:
-			listenFd: The listening socket with pending connection
+			listenFd: The listening socket with pending connection(s)
 
-		Returns: Client FD on success, -1 on failure
+		Returns: FD of the last accepted client, -1 if none accepted
 	*/
 	int acceptNewConnection(int listenFd);
 
+	/*
+		readListenQueueStats() - Kernel SYN-drop counters
+
+		Reads TcpExt ListenOverflows / ListenDrops from
+		/proc/net/netstat (system-wide, Linux). Sampled at init() and
+		again at stop() so the shutdown summary shows how many
+		connections the kernel dropped on a full accept queue while
+		we were running.
+
+		Returns false if the file or fields are unavailable.
+	*/
+	static bool readListenQueueStats(unsigned long& overflows,
+										unsigned long& drops);
+
 	/*
 		handleClientEvent() - Process events on a client socket
 
@@ -334,6 +535,24 @@ private:
 	*/
 	bool handleClientEvent(int clientFd, uint32_t events);
 
+	/*
+		flushClientWrites() - Push queued response bytes out now
+
+		With the one-shot EPOLLIN|EPOLLOUT edge-triggered arming (see
+		CLIENT_TRIGGER_MODE) a freshly queued response produces no
+		epoll event - the socket was writable all along. So whoever
+		queues bytes on a connection starts the send too: write until
+		done or EAGAIN, and when a response completes, route any
+		pipelined requests that reset() carried over and send those as
+		well. A partial write is fine - send() just filled the kernel
+		buffer, so the drain edge delivers EPOLLOUT and the event loop
+		resumes the transfer.
+
+		Returns: true to keep the connection, false if it should close
+		(write error, or the state machine reached CONN_CLOSED)
+	*/
+	bool flushClientWrites(Connection& conn);
+
 	/*
 		closeClientConnection() - Clean up a client connection
 
@@ -345,12 +564,60 @@ private:
 	void closeClientConnection(int clientFd);
 
 	/*
-		cleanupTimedOutConnections() - Remove stale connections
+		scheduleTimeout() - Insert a connection into the timer wheel
+
+		Hashes the connection's expiry time (lastActivity + timeout)
+		into its wheel slot. O(1). Called on accept; renewed activity
+		is handled lazily - see advanceTimerWheel().
+	*/
+	void scheduleTimeout(int clientFd, time_t expiry);
+
+	/*
+		advanceTimerWheel() - Process wheel slots due since last tick
+
+		Walks only the slots between the previous tick and now. For
+		each queued fd it re-checks the connection's REAL deadline
+		(activity may have pushed it forward since scheduling):
+
+			- connection gone:        drop the entry (lazy deletion)
+			- deadline in the future: re-hash into the new slot
+			- deadline passed:        close the connection
+
+		This replaces the old full scan over _connections: instead of
+		touching every connection every cleanup pass, each connection
+		is looked at O(1) times per timeout period.
+	*/
+	void advanceTimerWheel();
+
+	/*
+		enforceMemoryBudget() - Shed idle connections when over budget
+
+		Runs in the once-per-second cleanup pass. When the global
+		buffer gauge (Counters::bufferedBytes) exceeds the configured
+		memory_budget, idle keep-alive connections - CONN_READING
+		with nothing buffered in either direction - are closed oldest
+		first until the gauge is back under budget. Connections with
+		work in flight are never touched, so memory pressure sheds
+		history, not active requests.
+	*/
+	void enforceMemoryBudget();
 
-		Called periodically to close connections that have been
-		idle for too long.
+	/*
+		performConfigReload() - Parse, validate and swap the config
+
+		Runs in the event loop when _reloadPending is set. Parses the
+		original config file into a FRESH heap-allocated Config; on
+		any parse error the reload is abandoned and the server keeps
+		running on the current snapshot. On success the new snapshot
+		is swapped in atomically (single-threaded: between two loop
+		iterations) - new requests route against it, responses
+		already in flight drain unaffected, and no socket is touched.
+
+		Listen sockets are NOT rebound: changed or added listen
+		directives take effect on the next restart (rebinding would
+		drop the very connections a live reload exists to preserve).
 	*/
-	void cleanupTimedOutConnections();
+	void performConfigReload();
 
 	// =====================
 	//  Helper Functions
@@ -373,6 +640,111 @@ private:
 	// processRequest() - Route request and generate response
 	void processRequest(Connection& conn);
 
+	/*
+		getConnection() - O(1) connection lookup by fd
+
+		Returns: The connection in that slot, or NULL if none
+	*/
+	Connection* getConnection(int fd);
+
+
+	// =====================
+	//  Async CGI Handling
+	// =====================
+
+	/*
+		isCgiFd() - Check if FD belongs to an active CGI pipe
+
+		Used by the event loop to dispatch: listen socket / CGI pipe /
+		client socket.
+	*/
+	bool isCgiFd(int fd) const;
+
+	/*
+		handleCgiEvent() - Process events on a CGI pipe fd
+
+		stdinFd + EPOLLOUT: feed the next chunk of the request body
+		stdoutFd + EPOLLIN: collect the next chunk of script output
+		EOF on stdout: reap child, parse output, answer the client
+	*/
+	void handleCgiEvent(int fd, uint32_t events);
+
+	/*
+		tryStartCgiStream() - Switch an execution to chunked streaming
+
+		Called while collecting CGI stdout. Once the script's header
+		block (up to the blank line) is complete, queues a chunked
+		Response on the parked client and streams everything after the
+		headers - including all later pipe reads - as chunk frames.
+		Until the headers arrive (or for HTTP/1.0 clients, which don't
+		understand chunked encoding) output keeps buffering and the
+		EOF path answers the old way.
+
+		Returns: false if the client died while flushing the first
+		frames - the caller must close it and stop using the cgi
+	*/
+	bool tryStartCgiStream(ActiveCgi* cgi);
+
+	/*
+		resumePausedCgi() - Restart stdout reads after the client drained
+
+		Counterpart of the streaming backpressure: when a paused
+		execution's client write buffer falls back below the
+		watermark, its stdout pipe re-enters the epoll set and the
+		script unblocks. Called after every successful client write;
+		a lookup miss (no CGI, not paused) costs one small map scan.
+	*/
+	void resumePausedCgi(int clientFd);
+
+	/*
+		finishActiveCgi() - Complete a CGI execution and answer the client
+
+		errorCode == 0: parse cgi->output into the real response
+		errorCode != 0: send Response::error(errorCode) instead
+		                (504 timeout, 502 broken pipe, ...)
+
+		Always closes/deregisters both pipes, reaps the child (or
+		queues it for WNOHANG reaping), un-parks the client connection
+		and deletes the ActiveCgi.
+	*/
+	void finishActiveCgi(ActiveCgi* cgi, int errorCode);
+
+	/*
+		abortCgiForClient() - Kill the CGI tied to a closing client
+
+		Called from closeClientConnection(): if the client hangs up
+		while its script is still running, there is nobody left to
+		receive the output - kill the child and drop the state.
+	*/
+	void abortCgiForClient(int clientFd);
+
+	/*
+		reapCgiChildren() - Non-blocking reap of exited CGI children
+
+		Children that had not exited yet when their output was
+		consumed land on _cgiReapList; this polls them with
+		waitpid(WNOHANG) every loop tick so no zombies accumulate.
+	*/
+	void reapCgiChildren();
+
+	/*
+		cleanupTimedOutCgis() - Kill CGI scripts past CGI_TIMEOUT_SEC
+
+		Runs with the periodic connection cleanup. The parked client
+		gets a 504 Gateway Timeout.
+	*/
+	void cleanupTimedOutCgis();
+
+	/*
+		startPendingCgi() - Start the next queued CGI request
+
+		Requests that hit the cgi_workers cap wait (parked, FIFO) in
+		_cgiPendingClients instead of forking. Whenever a running
+		script finishes and frees a slot, this re-processes the
+		oldest still-connected waiter.
+	*/
+	void startPendingCgi();
+
 
 
 
@@ -383,12 +755,91 @@ private:
 	std::vector<ListenSocket>	_listenSockets;	// All listening sockets
 	bool						_running;		// Server state flag
 
+	/*
+		One Router for the whole server lifetime.
+
+		Routing itself is stateless, but the Router carries caches
+		(hot-file cache) that only pay off if they survive between
+		requests - so we no longer construct a Router per request.
+	*/
+	Router						_router;
+
 	// Epoll-specific members
 	int							_epollFd;		// Epoll instance FD
-	std::map<int, ClientInfo>	_clients;		// Active client connections
-	std::map<int, Connection>	_connections; 	// Client connections
+
+	/*
+		Flat connection table, indexed by fd.
+
+		File descriptors are small dense integers (the kernel always
+		hands out the lowest free one), so a vector indexed by fd
+		gives O(1) lookup per epoll event - no red-black-tree walk,
+		no rebalancing, one predictable cache line. NULL = free slot.
+
+		Connections are heap-allocated once at accept() and never
+		copied afterwards; the old std::map<int, Connection> copied
+		the whole object (buffers included) into the tree on insert.
+
+		The table grows on demand (resize to fd + 1) and is never
+		shrunk - a few KB of pointers at worst.
+	*/
+	std::vector<Connection*>	_connTable;		// fd -> connection (NULL = free)
+	size_t						_connectionCount;	// Live entries in _connTable
+
+	/*
+		Accept-path instrumentation (see acceptNewConnection()).
+
+		_acceptedTotal / _acceptBatchMax show how bursty arrivals are;
+		the listen-overflow baselines are the kernel's TcpExt counters
+		(ListenOverflows / ListenDrops from /proc/net/netstat) sampled
+		at init(), so stop() can report how many SYNs the kernel
+		dropped on a full accept queue DURING this run instead of us
+		inferring drops from client timeouts.
+	*/
+	unsigned long				_acceptedTotal;		// Connections accepted by this worker
+	unsigned long				_acceptBatchMax;	// Largest accept burst in one wakeup
+	unsigned long				_listenOverflowsBase;	// Kernel counter at init()
+	unsigned long				_listenDropsBase;		// Kernel counter at init()
+
+	/*
+		Per-IP connection accounting (see MAX_CONNS_PER_IP). The map
+		holds only IPs with at least one live connection - entries
+		are erased when their count reaches zero.
+	*/
+	std::map<std::string, int>	_ipConnCount;	// Live connections per source IP
+	unsigned long				_ipCapRejects;	// Connections refused by the cap
+
+	/*
+		Config reload state (see performConfigReload()).
+
+		_reloadPending is the only thing the SIGHUP handler touches
+		(sig_atomic_t is the one type guaranteed writable from a
+		handler). Reloaded Config objects are heap-allocated and
+		RETIRED, never deleted mid-run: routing tables, listen
+		sockets and anything mid-flight may still hold pointers into
+		an old snapshot, so retired snapshots stay valid until the
+		destructor. Reloads are human-triggered and rare - keeping a
+		few KB per reload is the price of never chasing a dangling
+		config pointer.
+	*/
+	volatile sig_atomic_t		_reloadPending;	// Set by the SIGHUP handler
+	std::vector<const Config*>	_ownedConfigs;	// Snapshots we must delete
+
 	std::set<int>				_listenFds;		// Set of listening FDs (for quick lookup)
 
+	// Prefork mode members
+	int							_workerId;		// 0 = master, 1..N-1 = children
+	std::vector<pid_t>			_workerPids;	// Child PIDs (master only)
+
+	// Async CGI members
+	std::map<int, ActiveCgi*>	_cgiPipes;		// Pipe fd -> execution (both fds)
+	std::vector<pid_t>			_cgiReapList;	// Exited-but-unreaped CGI children
+	int							_activeCgiCount;	// Running CGI children (cgi_workers cap)
+	std::vector<int>			_cgiPendingClients;	// FIFO of clients waiting for a slot
+
+	// Timer wheel members (connection timeouts)
+	std::vector<std::vector<int> >	_timerWheel;	// Slot -> fds expiring that second
+	time_t							_lastWheelTick;	// Last second already processed
+
 
 	// =====================
 	//  Disabled Operations
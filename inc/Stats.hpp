@@ -0,0 +1,125 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Stats.hpp                                          :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: anemet <anemet@student.42luxembourg.lu>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/09/01 14:10:00 by anemet            #+#    #+#             */
+/*   Updated: 2026/09/01 14:10:00 by anemet           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include <string>
+#include <cstddef>
+
+/*
+	=================================
+		STATS / LATENCY HISTOGRAMS
+	=================================
+
+	Per-stage latency instrumentation for the request path.
+
+	A p99 spike can come from disk, from a slow CGI script, from
+	routing, or from the client draining slowly - and without
+	per-stage numbers they all look the same from outside. Stats
+	keeps one histogram per pipeline stage plus one end-to-end:
+
+		parse  - Request::parse() calls (header/body/chunk decoding)
+		route  - Router::route() (path resolution, disk I/O, gzip)
+		write  - writev()/sendfile() batches back to the client
+		cgi    - fork to last pipe byte of a CGI execution
+		total  - first request byte to last response byte
+
+	HDR-style bucketing: microsecond durations land in power-of-two
+	buckets (bucket k holds [2^k, 2^(k+1)) us), so record() is a
+	handful of arithmetic ops and no allocation - cheap enough for
+	the hot path. Percentiles read from the buckets are accurate to
+	a factor of two, which is plenty to tell a 100 us route from a
+	20 ms disk read.
+
+	Disabled (the default) the whole surface costs one static bool
+	check per hook - the clock_gettime() calls are skipped too.
+	Enable with the server directive:
+
+		stats on;
+
+	Results are printed at shutdown next to the accept/listen-queue
+	summary. All state is static: one set of histograms per worker
+	process, matching the Logger.
+*/
+
+class Stats
+{
+	public:
+		/*
+			One histogram per instrumented stage. STAGE_COUNT is the
+			array size, not a stage.
+		*/
+		enum Stage
+		{
+			STAGE_PARSE = 0,
+			STAGE_ROUTE,
+			STAGE_WRITE,
+			STAGE_CGI,
+			STAGE_TOTAL,
+			STAGE_COUNT
+		};
+
+		static void setEnabled(bool on);
+
+		// Hot-path guard: hooks skip the clock when this is false
+		static bool enabled();
+
+		/*
+			nowUs() - Monotonic clock in microseconds
+
+			CLOCK_MONOTONIC: immune to NTP/wall-clock jumps, which
+			would otherwise show up as negative or giant durations.
+		*/
+		static unsigned long nowUs();
+
+		// Add one duration (microseconds) to a stage's histogram
+		static void record(Stage stage, unsigned long us);
+
+		/*
+			report() - Human-readable summary of every stage
+
+			One line per stage with count, min/mean/max and
+			p50/p90/p99/p999 read from the buckets. Stages that never
+			recorded are omitted.
+		*/
+		static std::string report();
+
+		// Drop all recorded samples (config reload, tests)
+		static void reset();
+
+	private:
+		Stats();	// Static-only class, never instantiated
+
+		/*
+			64 power-of-two buckets cover 1 us .. ~584000 years;
+			in practice everything lands in the first ~35.
+		*/
+		static const int BUCKET_COUNT = 64;
+
+		struct Histogram
+		{
+			unsigned long	count;
+			unsigned long	sumUs;
+			unsigned long	minUs;
+			unsigned long	maxUs;
+			unsigned long	buckets[BUCKET_COUNT];
+		};
+
+		// Value (microseconds) a given percentile falls under
+		static unsigned long percentile(const Histogram& h, double p);
+
+		static bool			_enabled;
+		static Histogram	_histograms[STAGE_COUNT];
+};
+
+#endif
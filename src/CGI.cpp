@@ -783,12 +783,12 @@ void CGI::buildEnvironment()
 */
 void CGI::addHttpHeaders()
 {
-	const std::map<std::string, std::string>& headers = _request->getHeaders();
+	const HeaderMap& headers = _request->getHeaders();
 
-	for (std::map<std::string, std::string>::const_iterator it = headers.begin();
+	for (HeaderMap::const_iterator it = headers.begin();
 		 it != headers.end(); ++it)
 	{
-		std::string name = it->first;
+		const std::string& name = it->first;
 		const std::string& value = it->second;
 
 		/*
@@ -796,16 +796,8 @@ void CGI::addHttpHeaders()
 			- Content-Type becomes CONTENT_TYPE (no HTTP_ prefix)
 			- Content-Length becomes CONTENT_LENGTH (no HTTP_ prefix)
 		*/
-		std::string lowerName = name;
-		for (size_t i = 0; i < lowerName.length(); ++i)
-		{
-			if (lowerName[i] >= 'A' && lowerName[i] <= 'Z')
-			{
-				lowerName[i] = lowerName[i] + 32;
-			}
-		}
-
-		if (lowerName == "content-type" || lowerName == "content-length")
+		if (HeaderMap::equalsNoCase(name, "Content-Type") ||
+			HeaderMap::equalsNoCase(name, "Content-Length"))
 		{
 			continue;  // Already handled above without HTTP_ prefix
 		}
@@ -1129,7 +1121,7 @@ bool CGI::setNonBlocking(int fd)
 
 
 /*
-	parseCgiOutput() - Parse raw CGI output into headers and body
+	parseOutput() - Parse raw CGI output into headers and body
 
 	CGI Output Format (RFC 3875):
 	-----------------------------
@@ -1160,7 +1152,7 @@ bool CGI::setNonBlocking(int fd)
 		true if valid CGI output
 		false if malformed (sets 502 Bad Gateway)
 */
-bool CGI::parseCgiOutput(const std::string& output, CGIResult& result)
+bool CGI::parseOutput(const std::string& output, CGIResult& result)
 {
 	// =========================================
 	//  Step 1: Find header/body separator
@@ -1961,9 +1953,9 @@ bool CGI::parseCgiOutput(const std::string& output, CGIResult& result)
 	// =========================================
 	//  Step 7: Parse CGI Output
 	// =========================================
-	if (!parseCgiOutput(cgiOutput, result))
+	if (!parseOutput(cgiOutput, result))
 	{
-		// parseCgiOutput sets error info (502 Bad Gateway)
+		// parseOutput sets error info (502 Bad Gateway)
 		return result;
 	}
 
@@ -1973,3 +1965,119 @@ bool CGI::parseCgiOutput(const std::string& output, CGIResult& result)
 	result.success = true;
 	return result;
 }
+
+
+// =========================================
+//  Asynchronous Execution
+// =========================================
+
+/*
+	startAsync() - Launch the CGI child and return immediately
+
+	Same pipe/fork/dup2/execve sequence as execute(), but the parent
+	does NOT write the body, read the output, or wait for the child
+	here. Instead the pipe fds are handed back (non-blocking) so the
+	Server can drive them from its epoll loop:
+
+		Server event loop                 CGI child
+		|                                 |
+		| EPOLLOUT on stdinFd:            |
+		|   write() body chunk ---------->| reads stdin
+		|   (close on completion = EOF)   |
+		| EPOLLIN on stdoutFd:            |
+		|   read() output chunk <---------| writes stdout
+		| EOF on stdoutFd:                | exit()
+		|   waitpid(WNOHANG), parse,      |
+		|   build response                |
+
+	This is what keeps one slow PHP script from stalling every other
+	connection: the loop only touches a CGI pipe when the kernel says
+	it's ready, exactly like a client socket.
+
+	Returns:
+		true on success (exec filled in), false on pipe/fork failure
+*/
+bool CGI::startAsync(AsyncExec& exec)
+{
+	if (!_ready)
+	{
+		return false;
+	}
+
+	int stdin_pipe[2] = {-1, -1};
+	int stdout_pipe[2] = {-1, -1};
+
+	if (pipe(stdin_pipe) == -1)
+	{
+		return false;
+	}
+
+	if (pipe(stdout_pipe) == -1)
+	{
+		closePipes(stdin_pipe, NULL);
+		return false;
+	}
+
+	pid_t pid = fork();
+
+	if (pid == -1)
+	{
+		closePipes(stdin_pipe, stdout_pipe);
+		return false;
+	}
+
+	if (pid == 0)
+	{
+		// Child: identical setup to execute() - see the comments there
+		if (dup2(stdin_pipe[0], STDIN_FILENO) == -1)
+		{
+			_exit(1);
+		}
+		if (dup2(stdout_pipe[1], STDOUT_FILENO) == -1)
+		{
+			_exit(1);
+		}
+
+		close(stdin_pipe[0]);
+		close(stdin_pipe[1]);
+		close(stdout_pipe[0]);
+		close(stdout_pipe[1]);
+
+		if (!_workingDirectory.empty())
+		{
+			if (chdir(_workingDirectory.c_str()) == -1)
+			{
+				// Non-fatal: script might work anyway with absolute paths
+			}
+		}
+
+		char** argv = getArgv();
+		char** envp = getEnvArray();
+
+		if (!argv || !envp)
+		{
+			if (argv) freeArgv(argv);
+			if (envp) freeEnvArray(envp);
+			_exit(1);
+		}
+
+		execve(_interpreterPath.c_str(), argv, envp);
+
+		freeArgv(argv);
+		freeEnvArray(envp);
+		_exit(2);
+	}
+
+	// Parent: close the child's pipe ends, keep ours non-blocking
+	close(stdin_pipe[0]);
+	close(stdout_pipe[1]);
+
+	setNonBlocking(stdin_pipe[1]);
+	setNonBlocking(stdout_pipe[0]);
+
+	exec.pid = pid;
+	exec.stdinFd = stdin_pipe[1];
+	exec.stdoutFd = stdout_pipe[0];
+
+	return true;
+}
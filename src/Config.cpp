@@ -12,6 +12,9 @@
 
 #include "Config.hpp"
 
+#include <sys/stat.h>	// stat() - root directories must exist at parse time
+#include <unistd.h>		// access() - CGI interpreters / error pages readable
+
 
 /*
 	key concepts
@@ -45,9 +48,12 @@ LocationConfig::LocationConfig() :
 	upload_path(""),
 	cgi_extension(""),
 	cgi_path(""),
+	cgi_workers(8),
+	cgi_max_output(0),
 	redirect_url(""),
 	redirect_code(0),
-	autoindex(false)
+	autoindex(false),
+	gzip(false)
 {
 	// By default, only allow GET, the safest HTTP method
 	// POST and DELETE must be explicitly enabled in config
@@ -69,7 +75,8 @@ LocationConfig::LocationConfig() :
 ServerConfig::ServerConfig() :
 	host("0.0.0.0"),
 	port(8080),
-	client_max_body_size(1048576) // 1MB default, same as many webservers
+	client_max_body_size(1048576), // 1MB default, same as many webservers
+	stats(false)
 {}
 
 
@@ -130,7 +137,7 @@ const LocationConfig* ServerConfig::findLocation(const std::string &uri) const
 		2. /etc/webserv/webserv.conf (system-wide)
 	We will use ./config directory for simplicity
 */
-Config::Config() : _configPath("config/default.conf")
+Config::Config() : _configPath("config/default.conf"), _workerProcesses(1), _memoryBudget(0)
 {
 	// Don't parse here - let main() call parseFile() explicitly
 	// parseFile(_configPath);
@@ -142,7 +149,7 @@ Config::Config() : _configPath("config/default.conf")
 	Used when the user specifies a config file on the command line:
 		./webserv /path/to/my/config.conf
 */
-Config::Config(const std::string& path) : _configPath(path)
+Config::Config(const std::string& path) : _configPath(path), _workerProcesses(1), _memoryBudget(0)
 {
 	parseFile(_configPath);
 	validateConfig();
@@ -281,6 +288,10 @@ void Config::parseFile(const std::string& path)
 		throw ConfigException("Cannot open config file: " + path);
 	}
 
+	// Remember where we were loaded from, so a SIGHUP reload can
+	// re-parse the same file
+	_configPath = path;
+
 	std::string line;
 	// read line-by-line into `line` without terminating '\n'
 	while (std::getline(file, line))
@@ -299,6 +310,60 @@ void Config::parseFile(const std::string& path)
 		if (line.find("server") == 0)
 		{
 			parseServerBlock(file, line);
+			continue;
+		}
+
+		/*
+			Top-level (global) directives live outside any server block,
+			NGINX-style. Currently supported:
+
+				worker_processes N;
+
+			Spawns N worker processes, each with its own listening sockets
+			(bound with SO_REUSEPORT) and its own epoll loop, so the kernel
+			load-balances accepted connections across CPU cores.
+		*/
+		if (line[line.length() - 1] == ';')
+		{
+			line = line.substr(0, line.length() - 1);
+		}
+
+		std::vector<std::string> tokens = split(line, ' ');
+		if (tokens.empty())		continue;
+
+		if (tokens[0] == "worker_processes")
+		{
+			if (tokens.size() < 2)
+			{
+				throw ConfigException("worker_processes directive requires a value");
+			}
+
+			int workers = std::atoi(tokens[1].c_str());
+
+			// Sanity bounds: 0/negative makes no sense, and hundreds of
+			// workers would only thrash the scheduler. 128 is generous.
+			if (workers < 1 || workers > 128)
+			{
+				throw ConfigException("worker_processes must be between 1 and 128");
+			}
+
+			_workerProcesses = workers;
+		}
+		else if (tokens[0] == "memory_budget")
+		{
+			/*
+				memory_budget directive: cap on the total bytes held in
+				Connection read/write buffers across the whole worker.
+				Format: memory_budget 256M;   (same suffixes as
+				client_max_body_size; 0 or absent = unlimited)
+				When exceeded, the server sheds idle keep-alive
+				connections, oldest first - see enforceMemoryBudget().
+			*/
+			if (tokens.size() < 2)
+			{
+				throw ConfigException("memory_budget directive requires a value");
+			}
+			_memoryBudget = parseSize(tokens[1]);
 		}
 	}
 
@@ -309,6 +374,11 @@ void Config::parseFile(const std::string& path)
 	{
 		throw ConfigException("No server blocks defined in config file");
 	}
+
+	// Semantic checks (valid ports, no duplicate vhosts, ...) - run
+	// here so every parse path is validated, including the SIGHUP
+	// reload, which must reject a bad file BEFORE swapping it in
+	validateConfig();
 }
 
 /*
@@ -443,6 +513,59 @@ void Config::parseServerBlock(std::ifstream& file, std::string& line)
 			}
 			server.client_max_body_size = parseSize(tokens[1]);
 		}
+		else if (directive == "access_log")
+		{
+			/*
+				access_log directive: where the buffered log goes
+				Format: access_log logs/access.log;
+				Without it the log stays on stdout. The Logger is
+				process-wide, so the FIRST server block's setting
+				wins (see Server::init()).
+			*/
+			if (tokens.size() < 2)
+			{
+				throw ConfigException("access_log directive requires a path");
+			}
+			server.access_log = tokens[1];
+		}
+		else if (directive == "log_level")
+		{
+			/*
+				log_level directive: how chatty the log is
+				Format: log_level debug|info|error|none;
+				'info' (the default) gives one access line per
+				request; 'debug' restores the per-event chatter.
+			*/
+			if (tokens.size() < 2)
+			{
+				throw ConfigException("log_level directive requires a value");
+			}
+			if (tokens[1] != "debug" && tokens[1] != "info" &&
+				tokens[1] != "error" && tokens[1] != "none")
+			{
+				throw ConfigException("log_level must be debug, info, error or none");
+			}
+			server.log_level = tokens[1];
+		}
+		else if (directive == "stats")
+		{
+			/*
+				stats directive: per-stage latency histograms
+				Format: stats on|off;
+				Off (the default) the instrumentation hooks cost one
+				branch each; on, each stage records into its histogram
+				and a summary prints at shutdown.
+			*/
+			if (tokens.size() < 2)
+			{
+				throw ConfigException("stats directive requires on or off");
+			}
+			if (tokens[1] != "on" && tokens[1] != "off")
+			{
+				throw ConfigException("stats must be on or off");
+			}
+			server.stats = (tokens[1] == "on");
+		}
 
 	} //end of server while (getline) loop
 
@@ -578,6 +701,20 @@ void Config::parseLocationBlock(std::ifstream& file, std::string& line, ServerCo
 			*/
 			location.autoindex = (tokens[1] == "on");
 		}
+		else if (directive == "gzip")
+		{
+			/*
+				gzip directive: enable response compression
+				Example: gzip on;
+
+				Text-like responses (HTML, CSS, JS, JSON, ...) are
+				compressed when the client sends Accept-Encoding: gzip.
+				For static files the Router first looks for a
+				precompressed sibling (file.ext.gz) and serves that
+				with zero CPU cost per request.
+			*/
+			location.gzip = (tokens[1] == "on");
+		}
 		else if (directive == "upload_path" || directive == "upload_store")
 		{
 			/*
@@ -617,6 +754,51 @@ void Config::parseLocationBlock(std::ifstream& file, std::string& line, ServerCo
 			}
 			location.cgi_extension = tokens[1];
 		}
+		else if (directive == "cgi_workers")
+		{
+			/*
+				cgi_workers directive: max concurrent CGI children
+				Example: cgi_workers 8;
+
+				Caps how many interpreter processes this location may
+				have running at once. Requests arriving above the cap
+				are queued and started as running scripts finish -
+				bounding fork storms the same way a FastCGI worker
+				pool of N processes would.
+			*/
+			if (tokens.size() < 2)
+			{
+				throw ConfigException("cgi_workers directive requires a value");
+			}
+
+			int workers = std::atoi(tokens[1].c_str());
+
+			// Sanity bounds: each worker is a full interpreter process,
+			// so more than 64 concurrent ones is never what you want
+			if (workers < 1 || workers > 64)
+			{
+				throw ConfigException("cgi_workers must be between 1 and 64");
+			}
+
+			location.cgi_workers = workers;
+		}
+		else if (directive == "cgi_max_output")
+		{
+			/*
+				cgi_max_output directive: cap a script's total output
+				Example: cgi_max_output 10M;
+
+				A script that produces more than this is killed and the
+				client gets a 502 (or a truncated stream if the headers
+				were already sent). 0 / unset = unlimited. Accepts the
+				same k/m/g suffixes as client_max_body_size.
+			*/
+			if (tokens.size() < 2)
+			{
+				throw ConfigException("cgi_max_output directive requires a value");
+			}
+			location.cgi_max_output = parseSize(tokens[1]);
+		}
 		else if (directive == "return")
 		{
 			/*
@@ -736,6 +918,54 @@ void Config::validateConfig() const
 			{
 				throw ConfigException("Redirect code must be 3xx");
 			}
+
+			/*
+				Filesystem checks - fail at parse time, not on the
+				first request. A typo'd root or interpreter path used
+				to surface as runtime 404s and 502s long after the
+				deploy; here it aborts startup (and aborts a SIGHUP
+				reload, which then keeps the old working config).
+				Redirect-only locations have nothing to check.
+			*/
+			if (!loc.redirect_url.empty())
+			{
+				continue;
+			}
+			if (!loc.root.empty())
+			{
+				struct stat rootStat;
+				if (stat(loc.root.c_str(), &rootStat) != 0
+					|| !S_ISDIR(rootStat.st_mode))
+				{
+					throw ConfigException("Location " + loc.path
+						+ ": root is not an existing directory: "
+						+ loc.root);
+				}
+			}
+			if (!loc.cgi_path.empty()
+				&& access(loc.cgi_path.c_str(), X_OK) != 0)
+			{
+				throw ConfigException("Location " + loc.path
+					+ ": CGI interpreter is not executable: "
+					+ loc.cgi_path);
+			}
+		}
+
+		/*
+			Error pages have a built-in fallback, so an unreadable
+			file is only worth a warning - but say it NOW, once, not
+			as a silent fallback on every 404 after the deploy.
+		*/
+		for (std::map<int, std::string>::const_iterator ep =
+				server.error_pages.begin();
+			 ep != server.error_pages.end(); ++ep)
+		{
+			if (access(ep->second.c_str(), R_OK) != 0)
+			{
+				std::cerr << "Warning: error_page " << ep->first
+						  << " file not readable: " << ep->second
+						  << " (built-in page will be used)" << std::endl;
+			}
 		}
 	}
 }
@@ -751,6 +981,30 @@ const std::vector<ServerConfig>& Config::getServers() const
 }
 
 
+/*
+	getWorkerProcesses: Number of worker processes to prefork
+	1 (the default) means classic single-process operation.
+*/
+int Config::getWorkerProcesses() const
+{
+	return _workerProcesses;
+}
+
+/*
+	getMemoryBudget: Total Connection-buffer byte budget per worker
+	0 (the default) means unlimited.
+*/
+size_t Config::getMemoryBudget() const
+{
+	return _memoryBudget;
+}
+
+const std::string& Config::getConfigPath() const
+{
+	return _configPath;
+}
+
+
 /*
 	getServerByHostPort: Find a server config by its listen address
 	Used to route incoming connections to the correct server block
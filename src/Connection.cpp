@@ -13,12 +13,19 @@
 #include "Connection.hpp"
 #include "Request.hpp"
 #include "Response.hpp"
+#include "Logger.hpp"
+#include "Stats.hpp"
+#include "Counters.hpp"
 
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/sendfile.h>	// sendfile() for zero-copy file responses
+#include <sys/uio.h>		// writev() for scatter-gather header+body sends
+#include <fcntl.h>			// open() for file-backed bodies
 #include <errno.h>
 #include <cstring>
 #include <iostream>
+#include <sstream>		// std::ostringstream for chunk framing
 
 /*
 	=================================================================
@@ -68,6 +75,20 @@
 */
 static const size_t RECV_BUFFER_SIZE = 8192;
 
+/*
+	Buffers whose capacity exceeds this are released on reset()
+	instead of kept for reuse.
+
+	Why shrink at all? std::string::clear() keeps capacity, which is
+	exactly right for the common case (a keep-alive connection serving
+	similar-sized responses reuses its allocation). But one 5 MB
+	response would pin 5 MB on that connection FOREVER - 10k such
+	connections pin 50 GB for work finished long ago. Above the
+	watermark the memory goes back to the allocator and the next
+	request starts from a small allocation again.
+*/
+static const size_t BUFFER_SHRINK_WATERMARK = 64 * 1024;	// 64 KB
+
 
 // =================================================================
 //  CONSTRUCTORS & DESTRUCTOR
@@ -86,14 +107,26 @@ Connection::Connection() :
 	_clientIP(""),
 	_clientPort(0),
 	_serverPort(0),
+	_vhostServer(NULL),
+	_vhostGeneration(0),
 	_connectTime(0),
 	_lastActivity(0),
+	_requestFirstByte(0),
+	_requestStartUs(0),
 	_state(CONN_READING),
 	_keepAlive(true),
 	_readBuffer(""),
 	_writeBuffer(""),
 	_writeOffset(0),
-	_request(NULL)
+	_bodyBuffer(""),
+	_bodyOffset(0),
+	_fileFd(-1),
+	_fileOffset(0),
+	_fileRemaining(0),
+	_request(NULL),
+	_pipelinedPartial(false),
+	_chunkStream(false),
+	_accountedBytes(0)
 {
 	// Invalid connection - must be properly initialized before use
 }
@@ -119,12 +152,24 @@ Connection::Connection(int fd, const struct sockaddr_in& clientAddr, int serverP
 	_fd(fd),
 	_clientPort(ntohs(clientAddr.sin_port)),
 	_serverPort(serverPort),
+	_vhostServer(NULL),
+	_vhostGeneration(0),
+	_requestFirstByte(0),
+	_requestStartUs(0),
 	_state(CONN_READING),
 	_keepAlive(true),  // HTTP/1.1 default
 	_readBuffer(""),
 	_writeBuffer(""),
 	_writeOffset(0),
-	_request(NULL)
+	_bodyBuffer(""),
+	_bodyOffset(0),
+	_fileFd(-1),
+	_fileOffset(0),
+	_fileRemaining(0),
+	_request(NULL),
+	_pipelinedPartial(false),
+	_chunkStream(false),
+	_accountedBytes(0)
 {
 	// Convert IP address from binary to string
 	char ipBuffer[INET_ADDRSTRLEN];
@@ -152,11 +197,21 @@ Connection::Connection(int fd, const struct sockaddr_in& clientAddr, int serverP
 */
 Connection::~Connection()
 {
+	// Hand this connection's share of the global buffer gauge back
+	std::string().swap(_readBuffer);
+	std::string().swap(_writeBuffer);
+	std::string().swap(_bodyBuffer);
+	updateByteAccounting();
+
 	if (_request != NULL)
 	{
 		delete _request;
 		_request = NULL;
 	}
+
+	// Release any file fd held for a file-backed body.
+	// Unlike the socket (owned by the Server), this fd is ours.
+	closeFileBody();
 }
 
 
@@ -174,20 +229,42 @@ Connection::Connection(const Connection& other) :
 	_clientIP(other._clientIP),
 	_clientPort(other._clientPort),
 	_serverPort(other._serverPort),
+	_vhostHost(other._vhostHost),
+	_vhostServer(other._vhostServer),
+	_vhostGeneration(other._vhostGeneration),
 	_connectTime(other._connectTime),
 	_lastActivity(other._lastActivity),
+	_requestFirstByte(other._requestFirstByte),
+	_requestStartUs(other._requestStartUs),
 	_state(other._state),
 	_keepAlive(other._keepAlive),
 	_readBuffer(other._readBuffer),
 	_writeBuffer(other._writeBuffer),
 	_writeOffset(other._writeOffset),
-	_request(NULL)
+	_bodyBuffer(other._bodyBuffer),
+	_bodyOffset(other._bodyOffset),
+	_fileFd(-1),
+	_fileOffset(other._fileOffset),
+	_fileRemaining(other._fileRemaining),
+	_request(NULL),
+	_pipelinedPartial(false),
+	_chunkStream(false),
+	_accountedBytes(0)
 {
 	// Deep copy the request object
 	if (other._request != NULL)
 	{
 		_request = new Request(*other._request);
 	}
+
+	// Duplicate the file fd so each copy owns (and closes) its own
+	if (other._fileFd >= 0)
+	{
+		_fileFd = dup(other._fileFd);
+	}
+
+	// The copy holds its own allocations - report them separately
+	updateByteAccounting();
 }
 
 /*
@@ -212,19 +289,39 @@ Connection& Connection::operator=(const Connection& other)
 		_clientIP = other._clientIP;
 		_clientPort = other._clientPort;
 		_serverPort = other._serverPort;
+		_vhostHost = other._vhostHost;
+		_vhostServer = other._vhostServer;
+		_vhostGeneration = other._vhostGeneration;
 		_connectTime = other._connectTime;
 		_lastActivity = other._lastActivity;
+		_requestFirstByte = other._requestFirstByte;
+		_requestStartUs = other._requestStartUs;
 		_state = other._state;
 		_keepAlive = other._keepAlive;
 		_readBuffer = other._readBuffer;
 		_writeBuffer = other._writeBuffer;
 		_writeOffset = other._writeOffset;
+		_bodyBuffer = other._bodyBuffer;
+		_bodyOffset = other._bodyOffset;
+
+		updateByteAccounting();
+
+		// Replace our file fd with a duplicate of the other's
+		closeFileBody();
+		_fileOffset = other._fileOffset;
+		_fileRemaining = other._fileRemaining;
+		if (other._fileFd >= 0)
+		{
+			_fileFd = dup(other._fileFd);
+		}
 
 		// Deep copy request
 		if (other._request != NULL)
 		{
 			_request = new Request(*other._request);
 		}
+		_pipelinedPartial = other._pipelinedPartial;
+		_chunkStream = other._chunkStream;
 	}
 	return *this;
 }
@@ -241,16 +338,31 @@ Connection& Connection::operator=(const Connection& other)
 
 	Non-Blocking Read Process:
 	--------------------------
-	1. Call recv() to read whatever data is available
+	1. Call recv() in a LOOP to drain everything that's available
 	2. recv() returns immediately:
-	   - > 0: Got some data, append to buffer
+	   - > 0: Got some data, append to buffer, loop again
 	   - = 0: Client closed connection (EOF)
-	   - < 0 with EAGAIN: No data available (would block)
+	   - < 0 with EAGAIN: Socket drained (stop looping)
 	   - < 0 other: Real error
 
-	3. After reading, try to parse the HTTP request
+	3. After each chunk, try to parse the HTTP request
 	4. If request is complete, change state to CONN_WRITING
 
+	Why loop until EAGAIN?
+	----------------------
+	We register client sockets with EPOLLET (edge-triggered).
+	Edge-triggered epoll only notifies on state CHANGES, so we
+	MUST consume everything the kernel has buffered or we will
+	never hear about the leftover bytes again. The bonus is fewer
+	epoll_wait() wakeups: one event per burst of data instead of
+	one event per recv()-sized chunk.
+
+	We stop the loop early once a request is complete - the
+	response has to be generated before we care about more input.
+	That's safe because handleClientEvent() always re-arms the fd
+	with EPOLL_CTL_MOD, which re-triggers edge-triggered events
+	for data still pending in the kernel buffer.
+
 	Why we buffer:
 	--------------
 	HTTP requests can arrive in multiple TCP packets:
@@ -266,7 +378,7 @@ Connection& Connection::operator=(const Connection& other)
 */
 bool Connection::readData()
 {
-	// Temporary buffer for this recv() call
+	// Temporary buffer for each recv() call
 	char buffer[RECV_BUFFER_SIZE];
 
 	/*
@@ -289,100 +401,117 @@ bool Connection::readData()
 			- If no data available, returns -1 with errno = EAGAIN
 			- Never blocks, always returns immediately
 	*/
-	ssize_t bytesRead = recv(_fd, buffer, RECV_BUFFER_SIZE, 0);
-
-	// =========================================
-	//  Handle recv() result
-	// =========================================
-
-	if (bytesRead > 0)
+	while (true)
 	{
-		/*
-			Successfully received data!
+		ssize_t bytesRead = recv(_fd, buffer, RECV_BUFFER_SIZE, 0);
 
-			Append to our read buffer. The buffer accumulates data
-			across multiple recv() calls until we have a complete request.
-		*/
-		_readBuffer.append(buffer, bytesRead);
+		// =========================================
+		//  Handle recv() result
+		// =========================================
 
-		// Update activity timestamp (for timeout tracking)
-		updateActivity();
+		if (bytesRead > 0)
+		{
+			/*
+				Successfully received data!
 
-		std::cout << "  [Connection fd=" << _fd << "] Received "
-				  << bytesRead << " bytes (buffer now: "
-				  << _readBuffer.size() << " bytes)" << std::endl;
+				Append to our read buffer. The buffer accumulates data
+				across multiple recv() calls until we have a complete request.
+			*/
+			_readBuffer.append(buffer, bytesRead);
+			Counters::bytesIn += (unsigned long)bytesRead;
+			updateByteAccounting();
+
+			// First byte of a new request anchors the absolute header
+			// deadline (see getTimeoutDeadline)...
+			if (_requestFirstByte == 0)
+			{
+				_requestFirstByte = time(NULL);
+			}
+
+			// ...and starts the end-to-end clock
+			if (Stats::enabled() && _requestStartUs == 0)
+			{
+				_requestStartUs = Stats::nowUs();
+			}
+
+			// Update activity timestamp (for timeout tracking)
+			updateActivity();
+
+			LOG_DEBUG("  [Connection fd=" << _fd << "] Received "
+						<< bytesRead << " bytes (buffer now: "
+						<< _readBuffer.size() << " bytes)");
 
-		/*
-			Try to parse the accumulated data as an HTTP request.
+			/*
+				Try to parse the accumulated data as an HTTP request.
 
-			parseRequest() will:
-			- Feed data to the Request parser
-			- Return true when request is complete
-			- Return false if we need more data
-		*/
-		if (parseRequest())
-		{
-			// Request is complete! Ready to generate response.
-			// State will change to CONN_WRITING when setResponse() is called.
-			std::cout << "  [Connection fd=" << _fd << "] Request complete!"
-					  << std::endl;
+				parseRequest() will:
+				- Feed data to the Request parser
+				- Return true when request is complete
+				- Return false if we need more data
+			*/
+			if (parseRequest())
+			{
+				// Request is complete! Ready to generate response.
+				// State will change to CONN_WRITING when setResponse() is called.
+				// Stop draining - leftover bytes re-trigger after MOD re-arms.
+				LOG_DEBUG("  [Connection fd=" << _fd << "] Request complete!");
+				return true;
+			}
+
+			continue;  // Keep draining until EAGAIN
 		}
+		else if (bytesRead == 0)
+		{
+			/*
+				Client closed the connection gracefully.
 
-		return true;  // Connection should stay open
-	}
-	else if (bytesRead == 0)
-	{
-		/*
-			Client closed the connection gracefully.
-
-			This happens when:
-			- Client calls close() or shutdown()
-			- Browser navigates away
-			- Network connection is lost
+				This happens when:
+				- Client calls close() or shutdown()
+				- Browser navigates away
+				- Network connection is lost
 
-			We should close our side too.
-		*/
-		std::cout << "  [Connection fd=" << _fd << "] Client disconnected (EOF)"
-				  << std::endl;
-
-		_state = CONN_CLOSED;
-		return false;  // Connection should be closed
-	}
-	else // bytesRead < 0
-	{
-		/*
-			recv() returned an error.
+				We should close our side too.
+			*/
+			LOG_DEBUG("  [Connection fd=" << _fd << "] Client disconnected (EOF)");
 
-			Check errno to determine what happened:
-			- EAGAIN/EWOULDBLOCK: No data available (normal for non-blocking)
-			- ECONNRESET: Client forcefully closed connection
-			- Other: Real error
-		*/
-		if (errno == EAGAIN || errno == EWOULDBLOCK)
+			_state = CONN_CLOSED;
+			return false;  // Connection should be closed
+		}
+		else // bytesRead < 0
 		{
 			/*
-				No data available right now.
+				recv() returned an error.
 
-				This is NOT an error for non-blocking sockets!
-				It just means there's nothing to read at this moment.
-				Epoll will notify us when more data arrives.
+				Check errno to determine what happened:
+				- EAGAIN/EWOULDBLOCK: Socket fully drained (normal exit)
+				- ECONNRESET: Client forcefully closed connection
+				- Other: Real error
 			*/
-			return true;  // Connection should stay open
-		}
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+			{
+				/*
+					No more data available right now.
 
-		/*
-			Real error occurred.
+					This is NOT an error - it's how the drain loop ends.
+					Epoll will notify us when more data arrives.
+				*/
+				return true;  // Connection should stay open
+			}
 
-			Common errors:
-			- ECONNRESET: Connection reset by peer (client crashed/killed)
-			- ETIMEDOUT: Connection timed out
-			- ENOTCONN: Socket not connected
-		*/
-		std::cerr << "  [Connection fd=" << _fd << "] recv() error: "
-				  << strerror(errno) << std::endl;
+			/*
+				Real error occurred.
 
-		_state = CONN_ERROR;
-		return false;  // Connection should be closed
+				Common errors:
+				- ECONNRESET: Connection reset by peer (client crashed/killed)
+				- ETIMEDOUT: Connection timed out
+				- ENOTCONN: Socket not connected
+			*/
+			std::cerr << "  [Connection fd=" << _fd << "] recv() error: "
+					  << strerror(errno) << std::endl;
+
+			_state = CONN_ERROR;
+			return false;  // Connection should be closed
+		}
 	}
 }
 
@@ -392,30 +521,42 @@ bool Connection::readData()
 
 	This is the main writing function, called when epoll signals EPOLLOUT.
 
+	Scatter-Gather Writes with writev():
+	------------------------------------
+	The response lives in TWO buffers - the serialized header block
+	(_writeBuffer) and the body (_bodyBuffer). Instead of concatenating
+	them (which would copy the full body just to prepend ~200 bytes of
+	headers), we hand BOTH to the kernel in one call:
+
+	  struct iovec iov[2];
+	  iov[0] = remaining headers       iov[1] = remaining body
+	  writev(fd, iov, 2);
+
+	The kernel walks the array as if it were one contiguous buffer, so
+	headers and body still leave in the same TCP segments - we just
+	never paid for the userspace copy.
+
 	Non-Blocking Write Process:
 	---------------------------
-	1. Calculate how much data remains to be sent
-	2. Call send() to write as much as possible
-	3. send() returns immediately:
-	   - > 0: Sent some bytes, update offset
-	   - = 0: Nothing sent (unusual)
-	   - < 0 with EAGAIN: Buffer full, try again later
+	1. Build an iovec over whatever remains of headers + body
+	2. Call writev() in a LOOP until everything is out or EAGAIN
+	3. writev() returns immediately:
+	   - > 0: Sent some bytes (may span both iovecs), advance offsets
+	   - < 0 with EAGAIN: Kernel buffer full, try again later
 	   - < 0 other: Real error
 
 	4. When all data is sent:
 	   - If keep-alive: reset() and go back to READING
 	   - If not: mark as CLOSED
 
-	Why partial writes happen:
-	--------------------------
-	The kernel has limited buffer space for outgoing data.
-	If we try to send 100 KB but only 16 KB fits in the buffer,
-	send() returns 16384 and we try again later for the rest.
+	Like readData(), we loop until EAGAIN. This is required for
+	edge-triggered epoll (we'd otherwise stall with data queued and
+	no further EPOLLOUT edge), and it lets a small response go out
+	in a single wakeup instead of one wakeup per call.
 
-	  _writeBuffer: [====================================]
-	                 ^                                   ^
-	           _writeOffset                            end
-	                 |<------- remaining data -------->|
+	Note on SIGPIPE: writev() has no MSG_NOSIGNAL equivalent, but
+	main() ignores SIGPIPE process-wide, so a client that vanished
+	mid-response surfaces as EPIPE here instead of killing us.
 
 	Returns:
 		true:  Write successful, connection should stay open
@@ -423,118 +564,232 @@ bool Connection::readData()
 */
 bool Connection::writeData()
 {
-	// Nothing to write?
-	if (_writeBuffer.empty() || _writeOffset >= _writeBuffer.size())
+	while (true)
 	{
-		// All data has been sent
-		// This shouldn't happen if we manage state correctly,
-		// but handle it gracefully
-		std::cout << "  [Connection fd=" << _fd << "] Write buffer empty"
-				  << std::endl;
-
-		return handleWriteComplete();
-	}
+		/*
+			Build the scatter-gather list over the UNSENT portion of
+			each buffer. A fully-sent (or empty) buffer contributes
+			no iovec - writev() with iovcnt 0 would be pointless, so
+			we fall through to the file/completion logic below.
+		*/
+		struct iovec iov[2];
+		int iovCount = 0;
 
-	// Calculate remaining data to send
-	size_t remaining = _writeBuffer.size() - _writeOffset;
-	const char* dataPtr = _writeBuffer.c_str() + _writeOffset;
+		if (_writeOffset < _writeBuffer.size())
+		{
+			iov[iovCount].iov_base = (void*)(_writeBuffer.c_str() + _writeOffset);
+			iov[iovCount].iov_len = _writeBuffer.size() - _writeOffset;
+			++iovCount;
+		}
+		if (_bodyOffset < _bodyBuffer.size())
+		{
+			iov[iovCount].iov_base = (void*)(_bodyBuffer.c_str() + _bodyOffset);
+			iov[iovCount].iov_len = _bodyBuffer.size() - _bodyOffset;
+			++iovCount;
+		}
 
-	/*
-		send(fd, buffer, length, flags)
+		if (iovCount == 0)
+		{
+			// Headers and body are out - continue streaming a
+			// file-backed body if any, otherwise we're done
+			if (_fileFd >= 0 && _fileRemaining > 0)
+			{
+				return sendFileData();
+			}
+			if (_chunkStream)
+			{
+				// Chunked stream still open: more fragments are
+				// coming (CGI pipe) - stay in CONN_WRITING
+				return true;
+			}
+			return handleWriteComplete();
+		}
 
-		Sends data on a connected socket.
+		ssize_t bytesSent = writev(_fd, iov, iovCount);
 
-		Parameters:
-			fd:     Socket file descriptor
-			buffer: Data to send
-			length: Number of bytes to send
-			flags:  Usually 0 or MSG_NOSIGNAL
+		// =========================================
+		//  Handle writev() result
+		// =========================================
 
-		MSG_NOSIGNAL:
-			Prevents SIGPIPE signal if client has closed.
-			Without this, writing to a closed socket kills the process!
+		if (bytesSent > 0)
+		{
+			/*
+				Successfully sent some data!
 
-		Returns:
-			> 0: Number of bytes actually sent
-			= 0: Nothing sent (edge case)
-			< 0: Error (check errno)
+				The count may span both iovecs (e.g. all remaining
+				headers plus the first chunk of body), so drain the
+				header offset first, then the body offset.
+			*/
+			size_t sent = (size_t)bytesSent;
+			Counters::bytesOut += (unsigned long)bytesSent;
+			size_t headerLeft = _writeBuffer.size() - _writeOffset;
+
+			if (sent >= headerLeft)
+			{
+				_writeOffset = _writeBuffer.size();
+				_bodyOffset += sent - headerLeft;
+			}
+			else
+			{
+				_writeOffset += sent;
+			}
+
+			// Update activity timestamp
+			updateActivity();
+
+			LOG_DEBUG("  [Connection fd=" << _fd << "] Sent "
+						<< bytesSent << " bytes ("
+						<< (_writeOffset + _bodyOffset) << "/"
+						<< (_writeBuffer.size() + _bodyBuffer.size()) << ")");
+		}
+		else if (bytesSent == 0)
+		{
+			/*
+				writev() returned 0.
 
-		Non-blocking behavior:
-			- If kernel buffer is full, returns -1 with errno = EAGAIN
-			- Never blocks, always returns immediately
-	*/
-	ssize_t bytesSent = send(_fd, dataPtr, remaining, MSG_NOSIGNAL);
+				This is rare but can happen. Just try again later.
+			*/
+			return true;
+		}
+		else // bytesSent < 0
+		{
+			/*
+				writev() returned an error.
+			*/
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+			{
+				/*
+					Kernel buffer is full.
 
-	// =========================================
-	//  Handle send() result
-	// =========================================
+					This is normal - we're sending faster than the network.
+					Epoll will notify us when buffer space is available.
+				*/
+				return true;  // Keep connection, try again later
+			}
 
-	if (bytesSent > 0)
-	{
-		/*
-			Successfully sent some data!
+			/*
+				Real error occurred.
 
-			Update offset to track progress.
-			We might not have sent everything - that's fine,
-			epoll will notify us when we can send more.
-		*/
-		_writeOffset += bytesSent;
+				Common errors:
+				- EPIPE: Client closed connection (SIGPIPE is ignored in main)
+				- ECONNRESET: Connection reset by peer
+				- ENOTCONN: Socket not connected
+			*/
+			std::cerr << "  [Connection fd=" << _fd << "] writev() error: "
+					  << strerror(errno) << std::endl;
 
-		// Update activity timestamp
-		updateActivity();
+			_state = CONN_ERROR;
+			return false;
+		}
+	}
+}
 
-		std::cout << "  [Connection fd=" << _fd << "] Sent "
-				  << bytesSent << " bytes ("
-				  << _writeOffset << "/" << _writeBuffer.size() << ")"
-				  << std::endl;
 
-		// Check if we've sent everything
-		if (_writeOffset >= _writeBuffer.size())
-		{
-			return handleWriteComplete();
-		}
+/*
+	updateByteAccounting() - Report buffer capacity delta to Counters
 
-		return true;  // More data to send, keep connection open
+	The gauge tracks CAPACITY, not size: capacity is what actually
+	pins memory, and a cleared-but-not-shrunk buffer still counts.
+*/
+void Connection::updateByteAccounting()
+{
+	size_t current = _readBuffer.capacity()
+						+ _writeBuffer.capacity()
+						+ _bodyBuffer.capacity();
+	if (current >= _accountedBytes)
+	{
+		Counters::bufferedBytes += current - _accountedBytes;
 	}
-	else if (bytesSent == 0)
+	else
 	{
-		/*
-			send() returned 0.
-
-			This is rare but can happen. Just try again later.
-		*/
-		return true;
+		size_t release = _accountedBytes - current;
+		Counters::bufferedBytes -= (release > Counters::bufferedBytes)
+									? Counters::bufferedBytes : release;
 	}
-	else // bytesSent < 0
+	_accountedBytes = current;
+}
+
+
+/*
+	sendFileData() - Stream a file-backed body with sendfile()
+
+	sendfile(out_fd, in_fd, offset, count)
+	--------------------------------------
+	Copies data INSIDE the kernel, straight from the page cache to
+	the socket buffer. The file bytes never enter userspace, so a
+	500 MB download costs zero copies and zero allocations here
+	(versus four full copies with the read-into-string path).
+
+	Parameters:
+		out_fd: The socket (must be a socket on Linux)
+		in_fd:  The file (must support mmap-like access)
+		offset: In/out pointer - kernel advances it by bytes sent
+		count:  Maximum bytes to transfer this call
+
+	Returns:
+		> 0: Bytes transferred (may be short - loop!)
+		< 0: Error; EAGAIN means the socket buffer is full
+
+	Like send(), we loop until EAGAIN for edge-triggered epoll.
+*/
+bool Connection::sendFileData()
+{
+	while (_fileRemaining > 0)
 	{
-		/*
-			send() returned an error.
-		*/
-		if (errno == EAGAIN || errno == EWOULDBLOCK)
-		{
-			/*
-				Kernel buffer is full.
+		ssize_t bytesSent = sendfile(_fd, _fileFd, &_fileOffset, _fileRemaining);
 
-				This is normal - we're sending faster than the network.
-				Epoll will notify us when buffer space is available.
-			*/
-			return true;  // Keep connection, try again later
+		if (bytesSent > 0)
+		{
+			// sendfile() already advanced _fileOffset for us
+			_fileRemaining -= bytesSent;
+			Counters::bytesOut += (unsigned long)bytesSent;
+			updateActivity();
+
+			LOG_DEBUG("  [Connection fd=" << _fd << "] sendfile "
+						<< bytesSent << " bytes (" << _fileRemaining
+						<< " remaining)");
+		}
+		else if (bytesSent == 0)
+		{
+			// EOF before we sent everything: file was truncated
+			// underneath us. Nothing sensible to append - close.
+			std::cerr << "  [Connection fd=" << _fd
+					  << "] sendfile() hit premature EOF" << std::endl;
+			_state = CONN_ERROR;
+			return false;
+		}
+		else
+		{
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+			{
+				// Socket buffer full - epoll will wake us to continue
+				return true;
+			}
+
+			std::cerr << "  [Connection fd=" << _fd << "] sendfile() error: "
+					  << strerror(errno) << std::endl;
+			_state = CONN_ERROR;
+			return false;
 		}
+	}
 
-		/*
-			Real error occurred.
+	// Whole file went out
+	return handleWriteComplete();
+}
 
-			Common errors:
-			- EPIPE: Client closed connection (we'd get SIGPIPE without MSG_NOSIGNAL)
-			- ECONNRESET: Connection reset by peer
-			- ENOTCONN: Socket not connected
-		*/
-		std::cerr << "  [Connection fd=" << _fd << "] send() error: "
-				  << strerror(errno) << std::endl;
 
-		_state = CONN_ERROR;
-		return false;
+/*
+	closeFileBody() - Release the fd of a file-backed body
+*/
+void Connection::closeFileBody()
+{
+	if (_fileFd >= 0)
+	{
+		close(_fileFd);
+		_fileFd = -1;
 	}
+	_fileOffset = 0;
+	_fileRemaining = 0;
 }
 
 
@@ -553,8 +808,19 @@ bool Connection::writeData()
 */
 bool Connection::handleWriteComplete()
 {
-	std::cout << "  [Connection fd=" << _fd << "] Response complete!"
-			  << std::endl;
+	LOG_DEBUG("  [Connection fd=" << _fd << "] Response complete!");
+
+	// Close the end-to-end clock: first request byte to last
+	// response byte, queueing and every send() wakeup included
+	if (Stats::enabled() && _requestStartUs != 0)
+	{
+		Stats::record(Stats::STAGE_TOTAL, Stats::nowUs() - _requestStartUs);
+	}
+	_requestStartUs = 0;
+	_requestFirstByte = 0;	// Between requests - back to the idle timeout
+
+	// Done with any file-backed body
+	closeFileBody();
 
 	if (_keepAlive)
 	{
@@ -568,8 +834,12 @@ bool Connection::handleWriteComplete()
 
 			We reset state to read the next request.
 		*/
-		std::cout << "  [Connection fd=" << _fd << "] Keep-alive: waiting for next request"
-				  << std::endl;
+		LOG_DEBUG("  [Connection fd=" << _fd
+					<< "] Keep-alive: waiting for next request");
+
+		// The connection survives to serve another request - the
+		// reuse/requests ratio on /.webserv/status comes from this
+		++Counters::keepAliveReuses;
 
 		reset();
 		return true;  // Connection stays open
@@ -582,8 +852,7 @@ bool Connection::handleWriteComplete()
 			Client requested (or we decided) to close after this response.
 			Mark connection as closed for cleanup.
 		*/
-		std::cout << "  [Connection fd=" << _fd << "] Closing connection"
-				  << std::endl;
+		LOG_DEBUG("  [Connection fd=" << _fd << "] Closing connection");
 
 		_state = CONN_CLOSED;
 		return false;  // Connection should be closed
@@ -629,7 +898,12 @@ bool Connection::parseRequest()
 		return _request->isComplete() || _request->hasError();
 	}
 
+	unsigned long parseStart = Stats::enabled() ? Stats::nowUs() : 0;
 	bool complete = _request->parse(_readBuffer);
+	if (Stats::enabled())
+	{
+		Stats::record(Stats::STAGE_PARSE, Stats::nowUs() - parseStart);
+	}
 
 	// Clear the read buffer - the Request has consumed/stored it
 	_readBuffer.clear();
@@ -704,9 +978,9 @@ void Connection::determineKeepAlive()
 		_keepAlive = (lowerConnection == "keep-alive");
 	}
 
-	std::cout << "  [Connection fd=" << _fd << "] Keep-alive: "
-			  << (_keepAlive ? "yes" : "no")
-			  << " (HTTP version: " << httpVersion << ")" << std::endl;
+	LOG_DEBUG("  [Connection fd=" << _fd << "] Keep-alive: "
+				<< (_keepAlive ? "yes" : "no")
+				<< " (HTTP version: " << httpVersion << ")");
 }
 
 
@@ -720,26 +994,87 @@ void Connection::determineKeepAlive()
 	Called by the Server after the Router generates a response.
 
 	This function:
-	1. Builds the complete HTTP response string
-	2. Stores it in the write buffer
+	1. Copies the serialized header block (~200 bytes)
+	2. STEALS the body via Response::swapBody() - O(1), no copy
 	3. Changes state to WRITING
 
+	Header and body stay in separate buffers; writeData() sends
+	them together with a single writev() call.
+
 	Parameters:
-		response: The HTTP Response object to send
+		response: The HTTP Response object to send (left hollow -
+		          every caller discards it right after this call)
 */
-void Connection::setResponse(const Response& response)
+void Connection::setResponse(Response& response)
 {
 	/*
-		Build the complete HTTP response.
-
-		Response::build() generates:
-		- Status line: "HTTP/1.1 200 OK\r\n"
-		- Headers: "Content-Type: text/html\r\n..."
-		- Blank line: "\r\n"
-		- Body: "<html>..."
+		Pipelining: if a previous response is still queued, append
+		this one BEHIND it instead of overwriting. The wire order is
+		_writeBuffer then _bodyBuffer, so the new header block and
+		body simply go to the end of _bodyBuffer - both responses
+		then drain in the same writev() batch.
+
+		A file-backed response is never pending here: batching stops
+		at the first one (see nextPipelinedRequest()), so _fileFd is
+		always -1 when we append.
 	*/
-	_writeBuffer = response.build();
-	_writeOffset = 0;
+	bool queuedBehind = hasDataToWrite();
+
+	if (queuedBehind)
+	{
+		_bodyBuffer += response.getHeaderData();
+		std::string nextBody;
+		response.swapBody(nextBody);
+		_bodyBuffer += nextBody;
+	}
+	else
+	{
+		/*
+			getHeaderData() generates only:
+			- Status line: "HTTP/1.1 200 OK\r\n"
+			- Headers: "Content-Type: text/html\r\n..."
+			- Blank line: "\r\n"
+
+			The body is swapped in separately - for a 10 MB response
+			this saves two full-body copies versus the old
+			build()-then-assign concatenation.
+		*/
+		_writeBuffer = response.getHeaderData();
+		_writeOffset = 0;
+		_bodyBuffer.clear();
+		response.swapBody(_bodyBuffer);
+		_bodyOffset = 0;
+
+		// File-backed body: open the file now, stream it after the
+		// buffers. (The Response only carries the path - see
+		// Response::setFileBody().)
+		closeFileBody();
+	}
+
+	if (response.hasFileBody())
+	{
+		_fileFd = open(response.getFilePath().c_str(), O_RDONLY);
+		if (_fileFd < 0)
+		{
+			/*
+				The file vanished between routing and sending (or we
+				lost permission). The headers are already built, so
+				the cleanest recovery is to drop the connection -
+				sending a mismatched body would corrupt the stream.
+			*/
+			std::cerr << "  [Connection fd=" << _fd << "] open() failed for "
+					  << response.getFilePath() << ": " << strerror(errno)
+					  << std::endl;
+			_state = CONN_ERROR;
+			return;
+		}
+		_fileOffset = (off_t)response.getFileOffset();
+		_fileRemaining = response.getFileLength();
+	}
+
+	// An open chunked stream keeps the connection in CONN_WRITING
+	// until endChunkStream() queues the terminal frame
+	_chunkStream = response.isChunked();
 
 	// Update keep-alive from response
 	_keepAlive = response.shouldKeepAlive();
@@ -747,15 +1082,18 @@ void Connection::setResponse(const Response& response)
 	// Change state to writing
 	_state = CONN_WRITING;
 
-	std::cout << "  [Connection fd=" << _fd << "] Response queued ("
-			  << _writeBuffer.size() << " bytes)" << std::endl;
+	updateByteAccounting();
+
+	LOG_DEBUG("  [Connection fd=" << _fd << "] Response queued ("
+				<< (_writeBuffer.size() + _bodyBuffer.size()) << " bytes)");
 
 	/*
 	// if DEBUG print first 555 chars from the response
 	*/
 	#ifdef DEBUG
-		// getting response string
-		std::string responseStr = response.getData();
+		// getting response string (body already stolen - preview
+		// the header block plus whatever we buffered)
+		std::string responseStr = _writeBuffer + _bodyBuffer;
 
 		std::cerr << "  [Response fd=" << _fd << "] Sending response:" << std::endl;
 		std::cerr << "  ----------------------------------------" << std::endl;
@@ -774,6 +1112,85 @@ void Connection::setResponse(const Response& response)
 }
 
 
+/*
+	appendChunk() - Frame a body fragment as an HTTP/1.1 chunk
+
+	See the header for the framing format. Zero-length fragments are
+	dropped - a zero-size chunk would terminate the stream early.
+*/
+void Connection::appendChunk(const char* data, size_t len)
+{
+	if (len == 0)
+	{
+		return;
+	}
+
+	std::ostringstream frame;
+	frame << std::hex << len << "\r\n";
+	_bodyBuffer += frame.str();
+	_bodyBuffer.append(data, len);
+	_bodyBuffer += "\r\n";
+
+	updateByteAccounting();
+}
+
+
+/*
+	endChunkStream() - Terminate a chunked response
+*/
+void Connection::endChunkStream()
+{
+	_bodyBuffer += "0\r\n\r\n";
+	_chunkStream = false;
+
+	LOG_DEBUG("  [Connection fd=" << _fd << "] Chunk stream closed");
+}
+
+
+/*
+	nextPipelinedRequest() - Advance to the next pipelined request
+
+	Takes the bytes the client sent beyond the request we just
+	answered, resets the Request and re-parses them. See the header
+	for the full batching rules.
+*/
+bool Connection::nextPipelinedRequest()
+{
+	// Only batch while a response is queued on a keep-alive
+	// connection with no file-backed body pending
+	if (_state != CONN_WRITING || !_keepAlive || _fileFd >= 0
+		|| _chunkStream || !_request)
+	{
+		return false;
+	}
+
+	std::string leftover;
+	_request->takeLeftover(leftover);
+	_request->reset();
+
+	if (leftover.empty())
+	{
+		return false;	// Nothing pipelined - wait for the network
+	}
+
+	LOG_DEBUG("  [Connection fd=" << _fd << "] Pipelined data: "
+				<< leftover.size() << " bytes");
+
+	if (_request->parse(leftover))
+	{
+		// Complete request (or a parse error the Router turns into
+		// an error response) - caller routes it now
+		determineKeepAlive();
+		return true;
+	}
+
+	// Only a partial next request arrived - keep the half-parsed
+	// Request alive across reset() until the rest shows up
+	_pipelinedPartial = true;
+	return false;
+}
+
+
 /*
 	hasCompleteRequest() - Check if request is fully received
 
@@ -781,7 +1198,14 @@ void Connection::setResponse(const Response& response)
 */
 bool Connection::hasCompleteRequest() const
 {
-	return _request && _request->isComplete();
+	/*
+		A failed parse is "complete" too: the request will never
+		advance, and processRequest() turns its error code into the
+		4xx/5xx response. Without the hasError() half such requests
+		were never routed at all - the client just hung until the
+		header timeout closed the connection.
+	*/
+	return _request && (_request->isComplete() || _request->hasError());
 }
 
 
@@ -819,17 +1243,79 @@ void Connection::setState(ConnectionState state)
 */
 void Connection::reset()
 {
-	// Clear buffers
+	// Clear buffers - and release, not just clear, any that grew
+	// past the watermark (capacity survives clear(); a swap with a
+	// fresh string is the C++98 idiom for actually freeing it)
 	_readBuffer.clear();
+	if (_readBuffer.capacity() > BUFFER_SHRINK_WATERMARK)
+	{
+		std::string().swap(_readBuffer);
+	}
 	_writeBuffer.clear();
+	if (_writeBuffer.capacity() > BUFFER_SHRINK_WATERMARK)
+	{
+		std::string().swap(_writeBuffer);
+	}
 	_writeOffset = 0;
+	_bodyBuffer.clear();
+	if (_bodyBuffer.capacity() > BUFFER_SHRINK_WATERMARK)
+	{
+		std::string().swap(_bodyBuffer);
+	}
+	_bodyOffset = 0;
+
+	// Release any file-backed body
+	closeFileBody();
+	_chunkStream = false;
 
-	// Reset request object
-	if (_request)
+	// Reset request object - unless it already holds the half-parsed
+	// next pipelined request (the missing bytes arrive with the next
+	// read; see nextPipelinedRequest())
+	if (_pipelinedPartial)
 	{
-		delete _request;
+		_pipelinedPartial = false;
+
+		// The next request's first bytes are already in hand - the
+		// header deadline starts counting from now
+		_requestFirstByte = time(NULL);
+	}
+	else
+	{
+		/*
+			Pipelined bytes may still sit behind the request we just
+			answered (batching stops at a file-backed response, and
+			its followers wait here until the file drains). Carry
+			them over into the fresh Request or they'd be lost.
+
+			The Request object itself is REUSED, not reallocated:
+			reset() clears its strings and header vector in place, and
+			clear() keeps their capacity. A keep-alive connection that
+			serves thousands of requests therefore stops paying the
+			delete/new (and the re-growth of every internal buffer)
+			that used to happen once per request - the connection's
+			one Request acts as its arena, "rewound" by reset().
+		*/
+		std::string leftover;
+		if (_request)
+		{
+			_request->takeLeftover(leftover);
+			_request->reset();
+		}
+		else
+		{
+			_request = new Request();
+		}
+		if (!leftover.empty())
+		{
+			LOG_DEBUG("  [Connection fd=" << _fd
+						<< "] Carrying over " << leftover.size()
+						<< " pipelined bytes");
+			_request->parse(leftover);
+
+			// Same as above: the next request has already started
+			_requestFirstByte = time(NULL);
+		}
 	}
-	_request = new Request();
 
 	// Reset state
 	_state = CONN_READING;
@@ -838,8 +1324,9 @@ void Connection::reset()
 	// Update activity timestamp
 	updateActivity();
 
-	std::cout << "  [Connection fd=" << _fd << "] Reset for next request"
-			  << std::endl;
+	updateByteAccounting();
+
+	LOG_DEBUG("  [Connection fd=" << _fd << "] Reset for next request");
 }
 
 
@@ -876,6 +1363,54 @@ bool Connection::isTimedOut(int timeoutSeconds) const
 	return (idleTime >= timeoutSeconds);
 }
 
+
+/*
+	getTimeoutDeadline() - Phase-aware timeout deadline
+
+	The classic Slowloris attack defeats a single idle timeout: send
+	one header byte every 59 seconds and the connection stays "active"
+	forever while occupying an fd and its buffers. The defense is to
+	make the HEADER phase an ABSOLUTE deadline anchored at the first
+	byte of the request - trickling does not extend it - while the
+	body phase (where slow uploads are legitimate) and the keep-alive
+	idle phase keep their idle-based timeouts.
+
+	Phase is derived from the parser state, so no extra bookkeeping
+	beyond the _requestFirstByte anchor is needed.
+*/
+time_t Connection::getTimeoutDeadline(int idleSec, int headerSec, int bodySec) const
+{
+	if (_request != NULL && _requestFirstByte != 0)
+	{
+		Request::ParseState state = _request->getState();
+
+		// Still reading the request line or headers: absolute
+		// deadline from the request's first byte
+		if (state == Request::PARSE_REQUEST_LINE
+			|| state == Request::PARSE_HEADERS)
+		{
+			return _requestFirstByte + headerSec;
+		}
+
+		// Reading the body: idle-based, but tighter than keep-alive
+		if (state == Request::PARSE_BODY
+			|| state == Request::PARSE_CHUNKED_BODY)
+		{
+			return _lastActivity + bodySec;
+		}
+	}
+
+	// Fresh connection that has never sent a byte: connect-and-stall
+	// gets the header budget, not the full keep-alive window
+	if (_lastActivity == _connectTime && _requestFirstByte == 0)
+	{
+		return _connectTime + headerSec;
+	}
+
+	// Keep-alive idle between requests, or writing a response
+	return _lastActivity + idleSec;
+}
+
 time_t Connection::getLastActivity() const
 {
 	return _lastActivity;
@@ -901,6 +1436,27 @@ int Connection::getServerPort() const
 	return _serverPort;
 }
 
+
+const ServerConfig* Connection::getCachedVhost(const std::string& host,
+												unsigned long generation) const
+{
+	if (_vhostServer && _vhostGeneration == generation && _vhostHost == host)
+	{
+		return _vhostServer;
+	}
+	return NULL;
+}
+
+
+void Connection::cacheVhost(const std::string& host,
+							const ServerConfig* server,
+							unsigned long generation)
+{
+	_vhostHost = host;
+	_vhostServer = server;
+	_vhostGeneration = generation;
+}
+
 const std::string& Connection::getClientIP() const
 {
 	return _clientIP;
@@ -952,6 +1508,15 @@ uint32_t Connection::getNeededEvents() const
 			// Have response data to send
 			return EPOLLOUT;
 
+		case CONN_CGI_WAIT:
+			/*
+				Parked while an async CGI child produces the response.
+				We still watch EPOLLIN so a client that hangs up mid-CGI
+				is detected (recv() returns 0) and the child can be
+				aborted instead of writing into a dead socket.
+			*/
+			return EPOLLIN;
+
 		case CONN_CLOSED:
 		case CONN_ERROR:
 		default:
@@ -963,5 +1528,22 @@ uint32_t Connection::getNeededEvents() const
 
 bool Connection::hasDataToWrite() const
 {
-	return !_writeBuffer.empty() && _writeOffset < _writeBuffer.size();
+	return (!_writeBuffer.empty() && _writeOffset < _writeBuffer.size())
+		|| (!_bodyBuffer.empty() && _bodyOffset < _bodyBuffer.size())
+		|| (_fileFd >= 0 && _fileRemaining > 0);
+}
+
+
+size_t Connection::getWriteBacklog() const
+{
+	size_t backlog = 0;
+	if (_writeOffset < _writeBuffer.size())
+	{
+		backlog += _writeBuffer.size() - _writeOffset;
+	}
+	if (_bodyOffset < _bodyBuffer.size())
+	{
+		backlog += _bodyBuffer.size() - _bodyOffset;
+	}
+	return backlog;
 }
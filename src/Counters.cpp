@@ -0,0 +1,106 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Counters.cpp                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: anemet <anemet@student.42luxembourg.lu>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/09/01 15:05:00 by anemet            #+#    #+#             */
+/*   Updated: 2026/09/01 15:05:00 by anemet           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Counters.hpp"
+
+#include <sstream>
+
+// ==============================================
+//       Static State
+// ==============================================
+
+unsigned long	Counters::accepted = 0;
+unsigned long	Counters::requests = 0;
+unsigned long	Counters::bytesIn = 0;
+unsigned long	Counters::bytesOut = 0;
+unsigned long	Counters::keepAliveReuses = 0;
+unsigned long	Counters::timeouts = 0;
+unsigned long	Counters::cgiStarted = 0;
+unsigned long	Counters::activeConnections = 0;
+unsigned long	Counters::cgiActive = 0;
+unsigned long	Counters::bufferedBytes = 0;
+time_t			Counters::startTime = 0;
+
+
+/*
+	Rates use whole elapsed seconds with a floor of 1, so a scrape
+	in the first second doesn't divide by zero and the numbers are
+	stable rather than spiky.
+*/
+static double rate(unsigned long total)
+{
+	time_t elapsed = time(NULL) - Counters::startTime;
+	if (elapsed < 1)
+	{
+		elapsed = 1;
+	}
+	return (double)total / (double)elapsed;
+}
+
+
+// =============================================
+//          Public Methods
+// =============================================
+
+std::string Counters::toJson()
+{
+	double reuseRatio = (requests > 0)
+						? (double)keepAliveReuses / (double)requests
+						: 0.0;
+
+	std::ostringstream oss;
+	oss << "{\n"
+		<< "  \"uptime_seconds\": " << (time(NULL) - startTime) << ",\n"
+		<< "  \"active_connections\": " << activeConnections << ",\n"
+		<< "  \"accepted_total\": " << accepted << ",\n"
+		<< "  \"accepts_per_second\": " << rate(accepted) << ",\n"
+		<< "  \"requests_total\": " << requests << ",\n"
+		<< "  \"requests_per_second\": " << rate(requests) << ",\n"
+		<< "  \"bytes_in_total\": " << bytesIn << ",\n"
+		<< "  \"bytes_out_total\": " << bytesOut << ",\n"
+		<< "  \"keepalive_reuses_total\": " << keepAliveReuses << ",\n"
+		<< "  \"keepalive_reuse_ratio\": " << reuseRatio << ",\n"
+		<< "  \"timeouts_total\": " << timeouts << ",\n"
+		<< "  \"cgi_started_total\": " << cgiStarted << ",\n"
+		<< "  \"cgi_active\": " << cgiActive << ",\n"
+		<< "  \"buffered_bytes\": " << bufferedBytes << "\n"
+		<< "}\n";
+	return oss.str();
+}
+
+std::string Counters::toPrometheus()
+{
+	std::ostringstream oss;
+	oss << "# TYPE webserv_uptime_seconds gauge\n"
+		<< "webserv_uptime_seconds " << (time(NULL) - startTime) << "\n"
+		<< "# TYPE webserv_active_connections gauge\n"
+		<< "webserv_active_connections " << activeConnections << "\n"
+		<< "# TYPE webserv_accepted_total counter\n"
+		<< "webserv_accepted_total " << accepted << "\n"
+		<< "# TYPE webserv_requests_total counter\n"
+		<< "webserv_requests_total " << requests << "\n"
+		<< "# TYPE webserv_bytes_in_total counter\n"
+		<< "webserv_bytes_in_total " << bytesIn << "\n"
+		<< "# TYPE webserv_bytes_out_total counter\n"
+		<< "webserv_bytes_out_total " << bytesOut << "\n"
+		<< "# TYPE webserv_keepalive_reuses_total counter\n"
+		<< "webserv_keepalive_reuses_total " << keepAliveReuses << "\n"
+		<< "# TYPE webserv_timeouts_total counter\n"
+		<< "webserv_timeouts_total " << timeouts << "\n"
+		<< "# TYPE webserv_cgi_started_total counter\n"
+		<< "webserv_cgi_started_total " << cgiStarted << "\n"
+		<< "# TYPE webserv_cgi_active gauge\n"
+		<< "webserv_cgi_active " << cgiActive << "\n"
+		<< "# TYPE webserv_buffered_bytes gauge\n"
+		<< "webserv_buffered_bytes " << bufferedBytes << "\n";
+	return oss.str();
+}
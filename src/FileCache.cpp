@@ -0,0 +1,177 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   FileCache.cpp                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: anemet <anemet@student.42luxembourg.lu>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/09/01 09:10:00 by anemet            #+#    #+#             */
+/*   Updated: 2026/09/01 09:10:00 by anemet           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "FileCache.hpp"
+#include "Response.hpp"	// formatHttpDate() for Last-Modified values
+
+#include <sstream>
+#include <iostream>
+#include <sys/stat.h>
+
+/*
+	=================================================================
+		FILECACHE IMPLEMENTATION
+	=================================================================
+
+	See FileCache.hpp for the design overview (LRU eviction, mtime
+	revalidation, size caps).
+*/
+
+
+FileCache::FileCache() :
+	_totalBytes(0),
+	_useCounter(0)
+{
+}
+
+FileCache::~FileCache()
+{
+}
+
+
+/*
+	get() - Look up a file by resolved path
+
+	Fast path (fresh entry): one map lookup, zero syscalls.
+	Slow path (entry older than the revalidate interval): one stat()
+	to confirm the file hasn't changed - still far cheaper than the
+	stat+open+read+close of an uncached request.
+*/
+const FileCacheEntry* FileCache::get(const std::string& path)
+{
+	std::map<std::string, FileCacheEntry>::iterator it = _entries.find(path);
+	if (it == _entries.end())
+	{
+		return NULL;	// Miss
+	}
+
+	FileCacheEntry& entry = it->second;
+	time_t now = time(NULL);
+
+	// Periodic mtime revalidation
+	if (now - entry.lastValidated >= CACHE_REVALIDATE_INTERVAL_SEC)
+	{
+		struct stat fileStat;
+		if (stat(path.c_str(), &fileStat) != 0
+			|| !S_ISREG(fileStat.st_mode)
+			|| fileStat.st_mtime != entry.mtime
+			|| (size_t)fileStat.st_size != entry.body.size())
+		{
+			// File changed or vanished - drop the stale entry
+			_totalBytes -= entry.body.size();
+			_entries.erase(it);
+			return NULL;
+		}
+
+		entry.lastValidated = now;
+	}
+
+	// Bump the LRU stamp
+	entry.lastUsed = ++_useCounter;
+
+	return &entry;
+}
+
+
+/*
+	put() - Insert (or refresh) a file in the cache
+
+	Precomputes the ETag and Last-Modified header values once here,
+	so cache hits don't re-format them per request.
+
+	ETag format: "<size-hex>-<mtime-hex>" (same scheme nginx uses).
+	It changes whenever the file's size or mtime changes, which is
+	exactly our staleness criterion.
+*/
+void FileCache::put(const std::string& path, const std::string& body,
+					const std::string& mimeType, time_t mtime)
+{
+	// Never cache oversized files (they are sendfile()'d anyway)
+	if (body.size() > CACHE_MAX_FILE_SIZE)
+	{
+		return;
+	}
+
+	// Refreshing an existing entry? Remove its old size first.
+	std::map<std::string, FileCacheEntry>::iterator it = _entries.find(path);
+	if (it != _entries.end())
+	{
+		_totalBytes -= it->second.body.size();
+	}
+
+	FileCacheEntry& entry = _entries[path];
+	entry.body = body;
+	entry.mimeType = mimeType;
+	entry.mtime = mtime;
+	entry.lastValidated = time(NULL);
+	entry.lastUsed = ++_useCounter;
+
+	// Precompute the validator headers
+	std::stringstream etag;
+	etag << "\"" << std::hex << body.size() << "-" << mtime << "\"";
+	entry.etag = etag.str();
+	entry.lastModified = Response::formatHttpDate(mtime);
+
+	_totalBytes += body.size();
+
+	evictIfNeeded();
+}
+
+
+void FileCache::clear()
+{
+	_entries.clear();
+	_totalBytes = 0;
+}
+
+
+size_t FileCache::getEntryCount() const
+{
+	return _entries.size();
+}
+
+size_t FileCache::getTotalBytes() const
+{
+	return _totalBytes;
+}
+
+
+/*
+	evictIfNeeded() - Evict LRU entries until under the byte budget
+
+	A linear scan for the minimum lastUsed stamp is O(n) per
+	eviction, but n is small (64 KB cap, 8 MB budget => at most a
+	few hundred entries) and evictions only happen when the budget
+	overflows - not on the per-request hot path.
+*/
+void FileCache::evictIfNeeded()
+{
+	while (_totalBytes > CACHE_MAX_TOTAL_BYTES && !_entries.empty())
+	{
+		std::map<std::string, FileCacheEntry>::iterator victim = _entries.begin();
+
+		for (std::map<std::string, FileCacheEntry>::iterator it = _entries.begin();
+			 it != _entries.end(); ++it)
+		{
+			if (it->second.lastUsed < victim->second.lastUsed)
+			{
+				victim = it;
+			}
+		}
+
+		std::cout << "  [FileCache] Evicting " << victim->first
+				  << " (" << victim->second.body.size() << " bytes)" << std::endl;
+
+		_totalBytes -= victim->second.body.size();
+		_entries.erase(victim);
+	}
+}
@@ -0,0 +1,228 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   HeaderMap.cpp                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: anemet <anemet@student.42luxembourg.lu>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/09/01 10:12:00 by anemet            #+#    #+#             */
+/*   Updated: 2026/09/01 10:12:00 by anemet           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "HeaderMap.hpp"
+
+/*
+	Canonical spellings of the standard header names we see in practice
+	(requests we parse + responses we emit). internName() matches
+	incoming names against this table case-insensitively, so a client
+	sending "HOST:" or "content-length:" ends up stored - and later
+	serialized - with the canonical casing below.
+*/
+static const char* const g_standardNames[] =
+{
+	"Accept",
+	"Accept-Charset",
+	"Accept-Encoding",
+	"Accept-Language",
+	"Authorization",
+	"Cache-Control",
+	"Connection",
+	"Content-Disposition",
+	"Content-Encoding",
+	"Content-Length",
+	"Content-Type",
+	"Cookie",
+	"Date",
+	"ETag",
+	"Expect",
+	"Expires",
+	"Host",
+	"If-Modified-Since",
+	"If-None-Match",
+	"Last-Modified",
+	"Location",
+	"Origin",
+	"Pragma",
+	"Range",
+	"Referer",
+	"Server",
+	"Set-Cookie",
+	"Transfer-Encoding",
+	"Upgrade",
+	"User-Agent",
+	"Vary",
+	"X-Forwarded-For"
+};
+
+static const size_t g_standardNameCount =
+	sizeof(g_standardNames) / sizeof(g_standardNames[0]);
+
+
+// ==============================================
+//       Constructors & Destructors
+// ==============================================
+
+HeaderMap::HeaderMap()
+{}
+
+HeaderMap::~HeaderMap()
+{}
+
+HeaderMap::HeaderMap(const HeaderMap& other) :
+	_entries(other._entries)
+{}
+
+HeaderMap& HeaderMap::operator=(const HeaderMap& other)
+{
+	if (this != &other)
+	{
+		_entries = other._entries;
+	}
+	return *this;
+}
+
+
+// =============================================
+//          Public Methods
+// =============================================
+
+void HeaderMap::set(const std::string& name, const std::string& value)
+{
+	long idx = findIndex(name);
+	if (idx >= 0)
+	{
+		// Duplicate name: last value wins, position is kept
+		_entries[static_cast<size_t>(idx)].second = value;
+		return;
+	}
+
+	// New header: prefer the interned standard spelling so lookups,
+	// CGI env building and the serialized response all see one casing
+	const std::string* interned = internName(name);
+	_entries.push_back(Entry(interned ? *interned : name, value));
+}
+
+const std::string& HeaderMap::get(const std::string& name) const
+{
+	// Shared miss value: callers get a reference, never a copy
+	static const std::string empty;
+
+	long idx = findIndex(name);
+	if (idx < 0)
+	{
+		return empty;
+	}
+	return _entries[static_cast<size_t>(idx)].second;
+}
+
+bool HeaderMap::has(const std::string& name) const
+{
+	return findIndex(name) >= 0;
+}
+
+void HeaderMap::remove(const std::string& name)
+{
+	long idx = findIndex(name);
+	if (idx >= 0)
+	{
+		_entries.erase(_entries.begin() + idx);
+	}
+}
+
+void HeaderMap::clear()
+{
+	_entries.clear();
+}
+
+bool HeaderMap::empty() const
+{
+	return _entries.empty();
+}
+
+size_t HeaderMap::size() const
+{
+	return _entries.size();
+}
+
+HeaderMap::const_iterator HeaderMap::begin() const
+{
+	return _entries.begin();
+}
+
+HeaderMap::const_iterator HeaderMap::end() const
+{
+	return _entries.end();
+}
+
+
+/*
+	equalsNoCase() - Case-insensitive string equality without temporaries
+
+	ASCII-only lowering is correct here: HTTP header names are token
+	characters (RFC 7230), never locale-dependent.
+*/
+bool HeaderMap::equalsNoCase(const std::string& a, const std::string& b)
+{
+	if (a.size() != b.size())
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		char ca = a[i];
+		char cb = b[i];
+		if (ca >= 'A' && ca <= 'Z')
+			ca = static_cast<char>(ca + 32);
+		if (cb >= 'A' && cb <= 'Z')
+			cb = static_cast<char>(cb + 32);
+		if (ca != cb)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+// =============================================
+//          Private Methods
+// =============================================
+
+long HeaderMap::findIndex(const std::string& name) const
+{
+	for (size_t i = 0; i < _entries.size(); i++)
+	{
+		if (equalsNoCase(_entries[i].first, name))
+		{
+			return static_cast<long>(i);
+		}
+	}
+	return -1;
+}
+
+/*
+	internName() - Map a name to its canonical standard spelling
+
+	The std::string pool is built once on first use; subsequent
+	inserts share those strings instead of copying the caller's
+	casing. Returns NULL for names outside the standard table
+	(custom X-* headers etc.), which are then stored as sent.
+*/
+const std::string* HeaderMap::internName(const std::string& name)
+{
+	// Built on first call; workers are single-threaded so a plain
+	// function-local static is safe here
+	static std::vector<std::string> pool(g_standardNames,
+											g_standardNames + g_standardNameCount);
+
+	for (size_t i = 0; i < pool.size(); i++)
+	{
+		if (equalsNoCase(pool[i], name))
+		{
+			return &pool[i];
+		}
+	}
+	return NULL;
+}
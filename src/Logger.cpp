@@ -0,0 +1,211 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Logger.cpp                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: anemet <anemet@student.42luxembourg.lu>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/09/01 11:40:00 by anemet            #+#    #+#             */
+/*   Updated: 2026/09/01 11:40:00 by anemet           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Logger.hpp"
+
+#include <iostream>		// std::cerr for open() failures
+#include <unistd.h>		// write(), close()
+#include <fcntl.h>		// open(), O_APPEND
+#include <cstring>		// strerror()
+#include <cerrno>		// errno
+#include <cstdio>		// snprintf()
+
+// ==============================================
+//       Static State
+// ==============================================
+
+int			Logger::_fd = 1;				// stdout until init() says otherwise
+LogLevel	Logger::_level = LOG_INFO;
+std::string	Logger::_buffer;
+time_t		Logger::_firstPending = 0;
+
+
+// =============================================
+//          Public Methods
+// =============================================
+
+bool Logger::init(const std::string& path, LogLevel level)
+{
+	_level = level;
+
+	if (path.empty())
+	{
+		return true;	// Keep stdout
+	}
+
+	// O_APPEND: atomic appends, so preforked workers sharing the
+	// file don't interleave inside each other's write() batches
+	int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+	if (fd < 0)
+	{
+		std::cerr << "Logger: cannot open " << path << ": "
+				  << strerror(errno) << " (logging to stdout)" << std::endl;
+		return false;
+	}
+
+	_fd = fd;
+	return true;
+}
+
+void Logger::setLevel(LogLevel level)
+{
+	_level = level;
+}
+
+bool Logger::parseLevel(const std::string& name, LogLevel& out)
+{
+	if (name == "debug")
+		out = LOG_DEBUG;
+	else if (name == "info")
+		out = LOG_INFO;
+	else if (name == "error")
+		out = LOG_ERROR;
+	else if (name == "none")
+		out = LOG_NONE;
+	else
+		return false;
+	return true;
+}
+
+bool Logger::debugEnabled()
+{
+	return _level <= LOG_DEBUG;
+}
+
+void Logger::debug(const std::string& line)
+{
+	if (_level <= LOG_DEBUG)
+	{
+		append(line);
+	}
+}
+
+void Logger::info(const std::string& line)
+{
+	if (_level <= LOG_INFO)
+	{
+		append(line);
+	}
+}
+
+void Logger::error(const std::string& line)
+{
+	if (_level <= LOG_ERROR)
+	{
+		append(line);
+	}
+}
+
+void Logger::access(const std::string& clientIP,
+					const std::string& method,
+					const std::string& uri,
+					const std::string& httpVersion,
+					int status, size_t bytes)
+{
+	if (_level > LOG_INFO)
+	{
+		return;
+	}
+
+	/*
+		Per-second timestamp cache: strftime() and gmtime() are far
+		too expensive to run per request when thousands of requests
+		share the same wall-clock second.
+	*/
+	static time_t cachedSecond = 0;
+	static char cachedStamp[40];
+	time_t now = time(NULL);
+	if (now != cachedSecond)
+	{
+		struct tm* tmNow = gmtime(&now);
+		strftime(cachedStamp, sizeof(cachedStamp),
+					"%d/%b/%Y:%H:%M:%S +0000", tmNow);
+		cachedSecond = now;
+	}
+
+	// Common Log Format; the two '-' are identd/userid (unused)
+	char tail[64];
+	snprintf(tail, sizeof(tail), "\" %d %lu", status, (unsigned long)bytes);
+
+	std::string line;
+	line.reserve(clientIP.size() + uri.size() + 64);
+	line += clientIP;
+	line += " - - [";
+	line += cachedStamp;
+	line += "] \"";
+	line += method;
+	line += ' ';
+	line += uri;
+	line += ' ';
+	line += httpVersion;
+	line += tail;
+
+	append(line);
+}
+
+void Logger::maybeFlush()
+{
+	if (_buffer.empty())
+	{
+		return;
+	}
+	if (_buffer.size() >= FLUSH_SIZE
+		|| time(NULL) - _firstPending >= FLUSH_INTERVAL_SEC)
+	{
+		flush();
+	}
+}
+
+void Logger::flush()
+{
+	size_t off = 0;
+	while (off < _buffer.size())
+	{
+		ssize_t written = write(_fd, _buffer.data() + off,
+								_buffer.size() - off);
+		if (written < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			break;	// Disk full / closed fd: drop the batch, don't spin
+		}
+		off += written;
+	}
+	_buffer.clear();	// clear() keeps capacity for the next batch
+}
+
+void Logger::shutdown()
+{
+	flush();
+	if (_fd > 2)
+	{
+		close(_fd);
+		_fd = 1;
+	}
+}
+
+
+// =============================================
+//          Private Methods
+// =============================================
+
+void Logger::append(const std::string& line)
+{
+	if (_buffer.empty())
+	{
+		_firstPending = time(NULL);
+	}
+	_buffer += line;
+	_buffer += '\n';
+}
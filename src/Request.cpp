@@ -12,6 +12,13 @@
 
 #include "Request.hpp"
 
+#include <unistd.h>		// write(), close(), unlink()
+#include <cstdio>		// (rename() lives here for consumers)
+#include <cstring>		// strerror()
+#include <cerrno>		// errno
+#include <stdlib.h>		// mkstemp()
+#include <cctype>		// isdigit() for Range header parsing
+
 // ==============================================
 //       Constructors & Destructors
 // ==============================================
@@ -37,13 +44,21 @@ Request::Request() :
 	_state(PARSE_REQUEST_LINE),
 	_errorCode(0),
 	_buffer(""),
+	_parsePos(0),
 	_contentLength(0),
 	_bodyBytesRead(0),
-	_expectedChunkSize(0)
+	_expectedChunkSize(0),
+	_bodyInFile(false),
+	_bodyFilePath(""),
+	_bodyFd(-1)
 {}
 
 // Destructor
-Request::~Request() {}
+Request::~Request()
+{
+	// Remove a still-owned spill file (no-op if it was renamed away)
+	discardBodyFile();
+}
 
 // Copy constructor
 Request::Request(const Request& other) :
@@ -57,9 +72,13 @@ Request::Request(const Request& other) :
 	_state(other._state),
 	_errorCode(other._errorCode),
 	_buffer(other._buffer),
+	_parsePos(other._parsePos),
 	_contentLength(other._contentLength),
 	_bodyBytesRead(other._bodyBytesRead),
-	_expectedChunkSize(other._expectedChunkSize)
+	_expectedChunkSize(other._expectedChunkSize),
+	_bodyInFile(other._bodyInFile),
+	_bodyFilePath(other._bodyFilePath),
+	_bodyFd(-1)	// The write fd stays with the original
 {}
 
 // copy assignment operator
@@ -77,9 +96,14 @@ Request& Request::operator=(const Request& other)
 		_state = other._state;
 		_errorCode = other._errorCode;
 		_buffer = other._buffer;
+		_parsePos = other._parsePos;
 		_contentLength = other._contentLength;
 		_bodyBytesRead = other._bodyBytesRead;
 		_expectedChunkSize = other._expectedChunkSize;
+		discardBodyFile();
+		_bodyInFile = other._bodyInFile;
+		_bodyFilePath = other._bodyFilePath;
+		_bodyFd = -1;	// The write fd stays with the original
 	}
 	return *this;
 }
@@ -109,12 +133,36 @@ void Request::reset()
 	_clientIP.clear();
 	_headers.clear();
 	_buffer.clear();
+	_parsePos = 0;
 
 	_state = PARSE_REQUEST_LINE;
 	_errorCode = 0;
 	_contentLength = 0;
 	_bodyBytesRead = 0;
 	_expectedChunkSize = 0;
+
+	// Drop the spill file of the previous request (keep-alive reuse)
+	discardBodyFile();
+}
+
+
+/*
+	takeLeftover() - Steal bytes buffered beyond this request
+
+	Swaps _buffer into `out` so the caller owns any pipelined bytes
+	before reset() would discard them. See Request.hpp.
+
+	The already-parsed prefix (up to _parsePos) is dropped first so
+	the caller only receives bytes this request never consumed.
+*/
+void Request::takeLeftover(std::string& out)
+{
+	if (_parsePos > 0)
+	{
+		_buffer.erase(0, _parsePos);
+		_parsePos = 0;
+	}
+	_buffer.swap(out);
 }
 
 
@@ -134,6 +182,26 @@ void Request::reset()
 */
 bool Request::parse(const std::string& data)
 {
+	/*
+		Consume-by-index instead of erase-per-line:
+
+		The states below advance _parsePos over _buffer rather than
+		calling _buffer.erase() for every request line, header line
+		and body fragment - each erase() memmoves the whole tail of
+		the buffer, which used to cost several moves per request.
+		The consumed prefix is dropped ONCE here, before appending
+		the new data; in the common case everything was consumed
+		last time, so this is a plain clear() with no copying.
+	*/
+	if (_parsePos > 0)
+	{
+		if (_parsePos >= _buffer.size())
+			_buffer.clear();
+		else
+			_buffer.erase(0, _parsePos);
+		_parsePos = 0;
+	}
+
 	// Add incoming data to the buffer
 	_buffer += data;
 
@@ -166,12 +234,12 @@ bool Request::parse(const std::string& data)
 	{
 		// Look for end of line: \r\n (CRLF)
 		// HTTP spec requires CRLF line endings
-		size_t pos = _buffer.find("\r\n");
+		size_t pos = _buffer.find("\r\n", _parsePos);
 		if (pos == std::string::npos)
 		{
 			// Not enough data yet, wait for more
 			// Prevent buffer overflow from malicious/broken clients
-			if (_buffer.size() > 8192) // 8 kB limit for request line
+			if (_buffer.size() - _parsePos > 8192) // 8 kB limit for request line
 			{
 				_state = PARSE_ERROR;
 				_errorCode = 414; // URI too long
@@ -181,10 +249,10 @@ bool Request::parse(const std::string& data)
 		}
 
 		// Extract request line (without \r\n)
-		std::string requestLine = _buffer.substr(0, pos);
+		std::string requestLine = _buffer.substr(_parsePos, pos - _parsePos);
 
-		// Remove processed data from buffer (including \r\n)
-		_buffer.erase(0, pos + 2);
+		// Mark data (including \r\n) as consumed
+		_parsePos = pos + 2;
 
 		// Parse the request line
 		if (!parseRequestLine(requestLine))
@@ -229,12 +297,12 @@ bool Request::parse(const std::string& data)
 		while (true)
 		{
 			// Look for next line ending
-			size_t pos = _buffer.find("\r\n");
+			size_t pos = _buffer.find("\r\n", _parsePos);
 			if (pos == std::string::npos)
 			{
 				// No complete line yet, need more data
 				// But prevent header section from being too large
-				if (_buffer.size() > 8192) // 8 kB size limit for all headers
+				if (_buffer.size() - _parsePos > 8192) // 8 kB size limit for all headers
 				{
 					_state = PARSE_ERROR;
 					_errorCode = 431; // Request Header Fields Too Large
@@ -244,10 +312,10 @@ bool Request::parse(const std::string& data)
 			}
 
 			// Extract the line (without \r\n)
-			std::string line = _buffer.substr(0, pos);
+			std::string line = _buffer.substr(_parsePos, pos - _parsePos);
 
-			// Remove processed line from buffer (including \r\n)
-			_buffer.erase(0, pos + 2);
+			// Mark the line (including \r\n) as consumed
+			_parsePos = pos + 2;
 
 			// Empty line marks end of headers
 			if (line.empty())
@@ -281,8 +349,9 @@ bool Request::parse(const std::string& data)
 					_contentLength = std::atol(contentLength.c_str());
 
 					// TODO: Check against client_max_body_size from config
-					// For now, use a default limit of 1MB
-					if(_contentLength > 1048576) // 1MB
+					// For now, use the global cap - large bodies no
+					// longer live in memory (see BODY_SPILL_THRESHOLD)
+					if(_contentLength > MAX_BODY_SIZE) // 100MB
 					{
 						_state = PARSE_ERROR;
 						_errorCode = 413; // Payload Too Large
@@ -291,6 +360,20 @@ bool Request::parse(const std::string& data)
 
 					if (_contentLength > 0)
 					{
+						/*
+							Large declared bodies go straight to disk:
+							we know up front they'd cross the spill
+							threshold, so don't buffer a single byte
+							of them in memory.
+						*/
+						if (_contentLength >= BODY_SPILL_THRESHOLD
+							&& !spillBodyToFile())
+						{
+							_state = PARSE_ERROR;
+							_errorCode = 500;
+							return true;
+						}
+
 						// Request has a body, move to body parsing
 						_state = PARSE_BODY;
 					}
@@ -371,24 +454,34 @@ bool Request::parse(const std::string& data)
 		size_t bytesNeeded = _contentLength - _bodyBytesRead;
 
 		// How many bytes are available in buffer?
-		size_t bytesAvailable = _buffer.size();
+		size_t bytesAvailable = _buffer.size() - _parsePos;
 
 		// Take the smaller of: what we need vs what we have
 		size_t bytesToRead = (bytesAvailable < bytesNeeded) ?
 								bytesAvailable : bytesNeeded;
 
-		// Append data from buffer to body
-		_body.append(_buffer, 0, bytesToRead);
-
-		// Remove consumed data from buffer
-		_buffer.erase(0, bytesToRead);
+		// Append data from buffer to body (memory or spill file)
+		if (!appendBodyBytes(_buffer.data() + _parsePos, bytesToRead))
+		{
+			_state = PARSE_ERROR;
+			_errorCode = 500;
+			return true;
+		}
 
-		// Update counter
-		_bodyBytesRead += bytesToRead;
+		// Mark consumed data (next parse() call drops it)
+		_parsePos += bytesToRead;
 
 		// Check if we have the complete body
 		if (_bodyBytesRead >= _contentLength)
 		{
+			// Spilled bodies: close the write fd - the file is
+			// complete and consumers will open/rename it themselves
+			if (_bodyFd >= 0)
+			{
+				close(_bodyFd);
+				_bodyFd = -1;
+			}
+
 			// Body complete! Request is ready to process
 			_state = PARSE_COMPLETE;
 			return true;
@@ -575,6 +668,23 @@ bool Request::parseRequestLine(const std::string& line)
 		_queryString = "";
 	}
 
+	// ===================================
+	//  Canonicalize the Path
+	// ===================================
+	/*
+		One scan does everything: percent-decoding, dot-segment
+		collapsing and byte validation. Doing it here means the Router
+		matches locations and builds filesystem paths from an already
+		canonical string - "/a/%2e%2e/b" and "/b" are the same request
+		by the time anyone looks at getPath(). The query string stays
+		raw: CGI scripts receive QUERY_STRING exactly as sent.
+	*/
+	if (_uri[0] == '/' && !normalizePath())
+	{
+		_errorCode = 400; // Bad Request (malformed escape or bytes)
+		return false;
+	}
+
 	// ===================================
 	//  Validate HTTP Version
 	// ===================================
@@ -592,6 +702,210 @@ bool Request::parseRequestLine(const std::string& line)
 	return true;
 }
 
+
+/*
+	hexDigit() - Value of one hex character, or -1 if not hex
+*/
+static int hexDigit(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+
+/*
+	closeSegment() - Collapse the just-finished path segment in place
+
+	Called when a '/' (or the end of the path) terminates a segment
+	of the output buffer:
+
+		"."  - current directory: dropped.        "/a/."  -> "/a/"
+		".." - parent directory: the previous     "/a/b/.." -> "/a/"
+		       segment goes too, clamped at the
+		       root so no URI can climb above it  "/.."   -> "/"
+
+	This runs on DECODED bytes, so "%2e%2e" collapses exactly like
+	a literal ".." - encoding a traversal doesn't hide it.
+*/
+static void closeSegment(std::string& out)
+{
+	size_t lastSlash = out.rfind('/');
+	if (lastSlash == std::string::npos)
+	{
+		return;	// Nothing closed yet (e.g. the "*" OPTIONS form)
+	}
+
+	size_t segLen = out.size() - lastSlash - 1;
+	if (segLen == 1 && out[lastSlash + 1] == '.')
+	{
+		out.resize(lastSlash + 1);
+	}
+	else if (segLen == 2 && out[lastSlash + 1] == '.'
+			&& out[lastSlash + 2] == '.')
+	{
+		if (lastSlash == 0)
+		{
+			out.resize(1);	// Clamped at the root
+		}
+		else
+		{
+			// The output always starts with '/', so this finds one
+			size_t prevSlash = out.rfind('/', lastSlash - 1);
+			out.resize(prevSlash + 1);
+		}
+	}
+}
+
+
+/*
+	normalizePath() - Canonicalize _path in a single scan
+
+	Replaces the old do-nothing handling (the path used to reach the
+	Router verbatim: "%69ndex.html" missed index.html on disk, and a
+	literal "/../" actually escaped the document root). One loop over
+	the bytes now performs, together:
+
+	1. Percent-decoding ("%2F" and friends). A broken escape is a
+	   hard 400, not a pass-through.
+	2. Dot-segment removal via closeSegment() - on the decoded
+	   bytes, so encoded traversals collapse too.
+	3. Duplicate-slash merging ("//a///b" -> "/a/b").
+	4. Byte validation: control characters (NUL included) are
+	   rejected, and multi-byte sequences must be well-formed UTF-8.
+
+	The inner loop bulk-copies runs of ordinary ASCII (no '%', '/',
+	control or high bytes) with one append per run - the common
+	all-ASCII path costs a single scan and a single copy, no
+	per-character branching through the decoder.
+*/
+bool Request::normalizePath()
+{
+	const std::string& in = _path;
+	const size_t n = in.size();
+	std::string out;
+	out.reserve(n);
+
+	size_t i = 0;
+	int utf8Remaining = 0;	// Continuation bytes still expected
+
+	while (i < n)
+	{
+		// Fast path: copy a run of ordinary bytes in one append
+		if (utf8Remaining == 0)
+		{
+			size_t run = i;
+			while (run < n)
+			{
+				unsigned char p = (unsigned char)in[run];
+				if (p <= 0x20 || p >= 0x7F || p == '%' || p == '/')
+				{
+					break;
+				}
+				++run;
+			}
+			if (run > i)
+			{
+				out.append(in, i, run - i);
+				i = run;
+				continue;
+			}
+		}
+
+		// Slow path: one byte, possibly percent-encoded
+		unsigned char c = (unsigned char)in[i];
+		if (c == '%')
+		{
+			if (i + 2 >= n)
+			{
+				return false;	// Truncated escape ("%4" at the end)
+			}
+			int hi = hexDigit(in[i + 1]);
+			int lo = hexDigit(in[i + 2]);
+			if (hi < 0 || lo < 0)
+			{
+				return false;	// "%zz" - not an escape at all
+			}
+			c = (unsigned char)((hi << 4) | lo);
+			i += 3;
+		}
+		else
+		{
+			++i;
+		}
+
+		// Control bytes never belong in a path (%00 tricks included)
+		if (c < 0x20 || c == 0x7F)
+		{
+			return false;
+		}
+
+		// UTF-8 well-formedness (decoded high bytes end up here too)
+		if (utf8Remaining > 0)
+		{
+			if ((c & 0xC0) != 0x80)
+			{
+				return false;	// Expected a continuation byte
+			}
+			--utf8Remaining;
+			out += (char)c;
+			continue;
+		}
+		if (c >= 0x80)
+		{
+			if ((c & 0xE0) == 0xC0)
+			{
+				utf8Remaining = 1;
+			}
+			else if ((c & 0xF0) == 0xE0)
+			{
+				utf8Remaining = 2;
+			}
+			else if ((c & 0xF8) == 0xF0)
+			{
+				utf8Remaining = 3;
+			}
+			else
+			{
+				return false;	// Stray continuation or invalid lead
+			}
+			out += (char)c;
+			continue;
+		}
+
+		if (c == '/')
+		{
+			closeSegment(out);
+			if (out.empty() || out[out.size() - 1] != '/')
+			{
+				out += '/';	// Also merges "//" runs
+			}
+			continue;
+		}
+
+		out += (char)c;
+	}
+
+	if (utf8Remaining != 0)
+	{
+		return false;	// Path ends mid multi-byte sequence
+	}
+
+	// The final segment has no trailing '/' to close it
+	closeSegment(out);
+
+	if (out.empty())
+	{
+		out = "/";
+	}
+	_path = out;
+	return true;
+}
+
 /*
 	parseHeader() - Parse a single HTTP header line
 
@@ -670,16 +984,13 @@ bool Request::parseHeader(const std::string& line)
 	}
 	value = value.substr(0, valueEnd);
 
-	// Convert header name to lowercase for case-insensitive storage
-	// HTTP headers are case-insensitive (RFC 7230)
-	std::string lowerName = name;
-	std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), ::tolower);
-
 	// Store the header
+	// HeaderMap matching is case-insensitive (RFC 7230) and interns
+	// standard names at insert - no per-request lowering needed here.
 	// Note: if header already exists, this will overwrite it
 	// Some headers can appear multiple times (e.g., Cookie, Set-Cookie)
 	// For simplicity we keep the last value (optional: handle multi-value headers)
-	_headers[lowerName] = value;
+	_headers.set(name, value);
 
 	return true;
 }
@@ -726,28 +1037,32 @@ bool Request::parseChunkedBody()
 			// We need: _expectedChunkSize bytes + "\r\n" (2 bytes)
 			size_t totalNeeded = _expectedChunkSize + 2;
 
-			if (_buffer.size() < totalNeeded)
+			if (_buffer.size() - _parsePos < totalNeeded)
 			{
 				// Don't have complete chunk yet, need more data
 				return false;
 			}
 
-			// Extract chunk data (without trailing \r\n)
-			std::string chunkData = _buffer.substr(0, _expectedChunkSize);
-
 			// Verify trailing CRLF after chunk data
-			if (_buffer.substr(_expectedChunkSize, 2) != "\r\n")
+			if (_buffer[_parsePos + _expectedChunkSize] != '\r' ||
+				_buffer[_parsePos + _expectedChunkSize + 1] != '\n')
 			{
 				_state = PARSE_ERROR;
 				_errorCode = 400; // Bad Request - malformed chunk
 				return false;
 			}
 
-			// Remove chunk data + trailing CRLF from buffer
-			_buffer.erase(0, totalNeeded);
+			// Append chunk to body (memory or spill file) straight
+			// from the buffer - no intermediate copy
+			if (!appendBodyBytes(_buffer.data() + _parsePos, _expectedChunkSize))
+			{
+				_state = PARSE_ERROR;
+				_errorCode = 500;
+				return false;
+			}
 
-			// Append chunk to body
-			_body.append(chunkData);
+			// Mark chunk data + trailing CRLF as consumed
+			_parsePos += totalNeeded;
 
 			// Reset expected size - ready to read next chunk size line
 			_expectedChunkSize = 0;
@@ -764,7 +1079,7 @@ bool Request::parseChunkedBody()
 		// Example: "1A\r\n" means next chunk is 26 bytes (0x1A = 26)
 
 		// Look for the CRLF that ends the chunk size line
-		size_t crlfPos = _buffer.find("\r\n");
+		size_t crlfPos = _buffer.find("\r\n", _parsePos);
 
 		if (crlfPos == std::string::npos)
 		{
@@ -772,7 +1087,7 @@ bool Request::parseChunkedBody()
 			// Wait for more data
 
 			// but prevent malicious clients from sending huge chunk size
-			if (_buffer.size() > 100) // shouldn't be > 100 chars before \r\n
+			if (_buffer.size() - _parsePos > 100) // shouldn't be > 100 chars before \r\n
 			{
 				_state = PARSE_ERROR;
 				_errorCode = 400; // Bad Request
@@ -782,7 +1097,7 @@ bool Request::parseChunkedBody()
 		}
 
 		// Extract chunk size line (without \r\n)
-		std::string chunkSizeLine = _buffer.substr(0, crlfPos);
+		std::string chunkSizeLine = _buffer.substr(_parsePos, crlfPos - _parsePos);
 
 		// Handle empty line - this is the final CRLF after "0\r\n"
 		// This happens when we've already processed the "0" chunk size
@@ -790,12 +1105,12 @@ bool Request::parseChunkedBody()
 		if (chunkSizeLine.empty())
 		{
 			// This is the final CRLF - chunked body is complete!
-			_buffer.erase(0, 2);  // Remove the \r\n
+			_parsePos += 2;  // Consume the \r\n
 			return true;
 		}
 
-		// Remove chunk size line from buffer (including \r\n)
-		_buffer.erase(0, crlfPos + 2);
+		// Mark chunk size line (including \r\n) as consumed
+		_parsePos = crlfPos + 2;
 
 		// ==================================
 		// Step 2: Parse Hex Chunk Size
@@ -869,15 +1184,22 @@ bool Request::parseChunkedBody()
 		{
 			// Last chunk! Now we need to wait for the final CRLF
 			// Check if it's already in the buffer
-			if (_buffer.size() >= 2)
+			if (_buffer.size() - _parsePos >= 2)
 			{
-				if (_buffer.substr(0, 2) != "\r\n")
+				if (_buffer[_parsePos] != '\r' || _buffer[_parsePos + 1] != '\n')
 				{
 					_state = PARSE_ERROR;
 					_errorCode = 400;
 					return false;
 				}
-				_buffer.erase(0, 2);
+				_parsePos += 2;
+
+				// Spilled bodies: close the write fd, the file is done
+				if (_bodyFd >= 0)
+				{
+					close(_bodyFd);
+					_bodyFd = -1;
+				}
 				return true;  // Chunked body complete!
 			}
 			// Need to wait for final CRLF
@@ -897,7 +1219,7 @@ bool Request::parseChunkedBody()
 				Client sends: 1000000\r\n<1MB data>\r\n1000000\r\n<1MB data>...
 				Without limit, serer runs out of memory
 		*/
-		if (_body.size() + chunkSize > 104857600) // 100MB limit for chunked
+		if (getBodySize() + chunkSize > MAX_BODY_SIZE) // 100MB limit for chunked
 		{
 			_state = PARSE_ERROR;
 			_errorCode = 413; // Payload Too Large
@@ -916,6 +1238,133 @@ bool Request::parseChunkedBody()
 
 }
 
+
+// ==================================
+//  Body Spill-to-Disk (large uploads)
+// ==================================
+
+/*
+	spillBodyToFile() - Switch the body from memory to disk
+
+	Called either up front (Content-Length >= BODY_SPILL_THRESHOLD) or
+	mid-stream when a chunked body crosses the threshold. mkstemp()
+	gives us a unique, already-open temp file with 0600 permissions -
+	no race between name generation and creation.
+
+	Whatever was accumulated in _body so far is flushed to the file
+	first, then _body is cleared and all further appendBodyBytes()
+	calls write straight to the fd.
+*/
+bool Request::spillBodyToFile()
+{
+	if (_bodyInFile)
+	{
+		return true;	// Already spilled
+	}
+
+	char pathTemplate[] = "/tmp/webserv_body_XXXXXX";
+	int fd = mkstemp(pathTemplate);
+	if (fd < 0)
+	{
+		std::cerr << "mkstemp() failed for body spill: "
+				  << strerror(errno) << std::endl;
+		return false;
+	}
+
+	// Flush what's already in memory (may be empty)
+	size_t offset = 0;
+	while (offset < _body.size())
+	{
+		ssize_t written = write(fd, _body.data() + offset,
+								_body.size() - offset);
+		if (written < 0)
+		{
+			close(fd);
+			unlink(pathTemplate);
+			return false;
+		}
+		offset += (size_t)written;
+	}
+
+	_bodyFd = fd;
+	_bodyFilePath = pathTemplate;
+	_bodyInFile = true;
+	_body.clear();
+
+	return true;
+}
+
+
+/*
+	appendBodyBytes() - Append body data, spilling when needed
+
+	The single funnel for body bytes from both the Content-Length and
+	chunked decoders. Keeps _bodyBytesRead authoritative and decides
+	transparently whether bytes land in _body or on disk.
+*/
+bool Request::appendBodyBytes(const char* data, size_t len)
+{
+	if (len == 0)
+	{
+		return true;
+	}
+
+	// Chunked bodies have no declared size - spill the moment the
+	// running total crosses the threshold
+	if (!_bodyInFile && _body.size() + len >= BODY_SPILL_THRESHOLD)
+	{
+		if (!spillBodyToFile())
+		{
+			return false;
+		}
+	}
+
+	if (_bodyInFile)
+	{
+		size_t offset = 0;
+		while (offset < len)
+		{
+			ssize_t written = write(_bodyFd, data + offset, len - offset);
+			if (written < 0)
+			{
+				std::cerr << "write() failed for body spill: "
+						  << strerror(errno) << std::endl;
+				return false;
+			}
+			offset += (size_t)written;
+		}
+	}
+	else
+	{
+		_body.append(data, len);
+	}
+
+	_bodyBytesRead += len;
+	return true;
+}
+
+
+/*
+	discardBodyFile() - Close the write fd and unlink the temp file
+
+	Safe to call unconditionally: after a consumer rename()d the file
+	into place the unlink simply fails with ENOENT.
+*/
+void Request::discardBodyFile()
+{
+	if (_bodyFd >= 0)
+	{
+		close(_bodyFd);
+		_bodyFd = -1;
+	}
+	if (_bodyInFile)
+	{
+		unlink(_bodyFilePath.c_str());
+		_bodyFilePath.clear();
+		_bodyInFile = false;
+	}
+}
+
 // =======================
 //  GETTERS
 // =======================
@@ -950,40 +1399,133 @@ const std::string& Request::getBody() const
 	return _body;
 }
 
-std::string Request::getHeader(const std::string& name) const
+const std::string& Request::getHeader(const std::string& name) const
 {
 	// HTTP headers are case-insensitive (RFC 7230)
 	// "Content-Type", "content-type", "CONTENT-TYPE" are all equivalent
-	// We need to do case-insensitive lookup
+	// HeaderMap compares names in place - no lowered temporaries, and
+	// the miss case returns a shared empty string instead of a copy
+	return _headers.get(name);
+}
 
-	// Convert search name to lowercase for comparison
-	std::string lowerName = name;
-	/*
-		apply standard C tolower() function to characters
-			from lowerName.begint() to lowerName.end()
-			write result to lowerName.begin() - this means string overwritten
-	*/
-	std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), ::tolower);
+const HeaderMap& Request::getHeaders() const
+{
+	return _headers;
+}
+
+
+/*
+	getByteRange() - Parse the Range header for a single byte range
+
+	Grammar (RFC 7233): Range: bytes=<first>-<last>
+	with <first> or <last> optionally absent:
+
+		bytes=0-499     first 500 bytes
+		bytes=500-      everything from byte 500
+		bytes=-500      last 500 bytes
+
+	Anything we can't serve with a single 206 (multiple ranges, other
+	units, garbage) returns RANGE_NONE and the caller serves the full
+	file - the RFC explicitly permits ignoring the header. A
+	syntactically valid range that lies entirely past EOF returns
+	RANGE_UNSATISFIABLE (the client's view of the file is stale or
+	wrong; 416 tells it to re-fetch from scratch).
+*/
+Request::RangeResult Request::getByteRange(size_t fileSize, size_t& offset,
+											size_t& length) const
+{
+	const std::string& range = getHeader("Range");
 
-	// Search through headers (assuming we store them in lowercase)
-	for (std::map<std::string, std::string>::const_iterator it = _headers.begin();
-			it != _headers.end(); ++it)
+	if (range.empty())
 	{
-		std::string headerName = it->first;
-		std::transform(headerName.begin(), headerName.end(), headerName.begin(), ::tolower);
+		return RANGE_NONE;
+	}
+
+	// Only byte ranges; anything else is ignorable per the RFC
+	if (range.compare(0, 6, "bytes=") != 0)
+	{
+		return RANGE_NONE;
+	}
+
+	std::string spec = range.substr(6);
+
+	// Multi-range needs multipart/byteranges framing - not worth it
+	// for the resume-a-download case this exists for
+	if (spec.find(',') != std::string::npos)
+	{
+		return RANGE_NONE;
+	}
 
-		if (headerName == lowerName)
+	size_t dash = spec.find('-');
+	if (dash == std::string::npos)
+	{
+		return RANGE_NONE;
+	}
+
+	std::string firstStr = spec.substr(0, dash);
+	std::string lastStr = spec.substr(dash + 1);
+
+	// Both parts must be plain digits (or absent)
+	for (size_t i = 0; i < firstStr.size(); ++i)
+	{
+		if (!isdigit((unsigned char)firstStr[i]))
+			return RANGE_NONE;
+	}
+	for (size_t i = 0; i < lastStr.size(); ++i)
+	{
+		if (!isdigit((unsigned char)lastStr[i]))
+			return RANGE_NONE;
+	}
+
+	if (firstStr.empty() && lastStr.empty())
+	{
+		return RANGE_NONE;	// "bytes=-" is meaningless
+	}
+
+	if (firstStr.empty())
+	{
+		// Suffix form: last N bytes of the file
+		size_t suffix = (size_t)strtoul(lastStr.c_str(), NULL, 10);
+		if (suffix == 0 || fileSize == 0)
+		{
+			return RANGE_UNSATISFIABLE;
+		}
+		if (suffix > fileSize)
 		{
-			return it->second;
+			suffix = fileSize;	// "more than everything" = everything
 		}
+		offset = fileSize - suffix;
+		length = suffix;
+		return RANGE_VALID;
 	}
 
-	return ""; // Header not found
-}
+	size_t first = (size_t)strtoul(firstStr.c_str(), NULL, 10);
+	if (first >= fileSize)
+	{
+		return RANGE_UNSATISFIABLE;	// Starts past EOF
+	}
 
-const std::map<std::string, std::string>& Request::getHeaders() const
-{
-	return _headers;
+	size_t last;
+	if (lastStr.empty())
+	{
+		last = fileSize - 1;	// Open-ended: to EOF
+	}
+	else
+	{
+		last = (size_t)strtoul(lastStr.c_str(), NULL, 10);
+		if (last < first)
+		{
+			return RANGE_NONE;	// Backwards range - ignore
+		}
+		if (last > fileSize - 1)
+		{
+			last = fileSize - 1;	// Clamp to EOF per the RFC
+		}
+	}
+
+	offset = first;
+	length = last - first + 1;
+	return RANGE_VALID;
 }
 
 Request::ParseState Request::getState() const
@@ -1013,9 +1555,27 @@ size_t Request::getContentLength() const
 
 size_t Request::getBodySize() const
 {
+	// For spilled bodies _body is empty - the byte counter tracks
+	// everything that went through appendBodyBytes() either way
+	if (_bodyInFile)
+	{
+		return _bodyBytesRead;
+	}
 	return _body.size();
 }
 
+
+bool Request::isBodyInFile() const
+{
+	return _bodyInFile;
+}
+
+
+const std::string& Request::getBodyFilePath() const
+{
+	return _bodyFilePath;
+}
+
 void Request::setClientIP(const std::string& ip)
 {
 	_clientIP = ip;
@@ -83,7 +83,11 @@ Response::Response() :
 	_statusCode(200),
 	_reasonPhrase("OK"),
 	_dirty(true),
-	_keepAlive(true)
+	_keepAlive(true),
+	_chunked(false),
+	_fileBody(false),
+	_fileOffset(0),
+	_fileLength(0)
 {}
 
 /*
@@ -112,9 +116,14 @@ Response::Response(const Response& other) :
 	_reasonPhrase(other._reasonPhrase),
 	_headers(other._headers),
 	_body(other._body),
-	_builtResponse(other._builtResponse),
+	_builtHeaders(other._builtHeaders),
 	_dirty(other._dirty),
-	_keepAlive(other._keepAlive)
+	_keepAlive(other._keepAlive),
+	_chunked(other._chunked),
+	_fileBody(other._fileBody),
+	_filePath(other._filePath),
+	_fileOffset(other._fileOffset),
+	_fileLength(other._fileLength)
 {}
 
 /*
@@ -131,9 +140,14 @@ Response& Response::operator=(const Response& other)
 		_reasonPhrase = other._reasonPhrase;
 		_headers = other._headers;
 		_body = other._body;
-		_builtResponse = other._builtResponse;
+		_builtHeaders = other._builtHeaders;
 		_dirty = other._dirty;
 		_keepAlive = other._keepAlive;
+		_chunked = other._chunked;
+		_fileBody = other._fileBody;
+		_filePath = other._filePath;
+		_fileOffset = other._fileOffset;
+		_fileLength = other._fileLength;
 	}
 	return *this;
 }
@@ -195,7 +209,7 @@ void Response::setStatus(int code, const std::string& reason)
 */
 void Response::setHeader(const std::string& name, const std::string& value)
 {
-	_headers[name] = value;
+	_headers.set(name, value);
 	_dirty = true;
 }
 
@@ -211,6 +225,7 @@ void Response::setHeader(const std::string& name, const std::string& value)
 void Response::setBody(const std::string& body)
 {
 	_body = body;
+	_fileBody = false;	// In-memory body replaces any file-backed one
 	_dirty = true;
 }
 
@@ -228,9 +243,72 @@ void Response::setBody(const std::string& body)
 void Response::setBody(const char* data, size_t length)
 {
 	_body.assign(data, length);
+	_fileBody = false;
 	_dirty = true;
 }
 
+/*
+	setFileBody() - Switch the response into file-backed mode
+
+	We deliberately store the PATH, not an open fd: Response objects
+	are returned by value and copied freely, and copying descriptor
+	ownership across those copies would be fragile. The Connection
+	opens the file once when the response is queued for sending.
+
+	Parameters:
+		path:   Absolute path of the file to stream
+		offset: First byte to send (0 for the whole file)
+		length: Number of bytes to send
+*/
+void Response::setFileBody(const std::string& path, size_t offset, size_t length)
+{
+	_filePath = path;
+	_fileOffset = offset;
+	_fileLength = length;
+	_fileBody = true;
+	_body.clear();		// Body lives on disk, nothing in memory
+	_dirty = true;
+}
+
+/*
+	setChunked() - Switch to Transfer-Encoding: chunked
+
+	Drops any Content-Length (a script may have sent one - it cannot
+	coexist with chunked framing) and advertises the encoding.
+*/
+void Response::setChunked()
+{
+	_chunked = true;
+	_headers.remove("Content-Length");
+	setHeader("Transfer-Encoding", "chunked");
+	_dirty = true;
+}
+
+bool Response::isChunked() const
+{
+	return _chunked;
+}
+
+bool Response::hasFileBody() const
+{
+	return _fileBody;
+}
+
+const std::string& Response::getFilePath() const
+{
+	return _filePath;
+}
+
+size_t Response::getFileOffset() const
+{
+	return _fileOffset;
+}
+
+size_t Response::getFileLength() const
+{
+	return _fileLength;
+}
+
 /*
 	setContentType() - Convenience method for Content-Type header
 
@@ -451,7 +529,7 @@ void Response::buildIfNeeded() const
 		Each header on its own line, colon-space between name and value.
 		Order doesn't matter (mostly), but consistency helps debugging.
 	*/
-	for (std::map<std::string, std::string>::const_iterator it = _headers.begin();
+	for (HeaderMap::const_iterator it = _headers.begin();
 		it != _headers.end(); ++it)
 	{
 		ss << it->first << ": " << it->second << "\r\n";
@@ -467,9 +545,15 @@ void Response::buildIfNeeded() const
 
 		Exception: 204 `No Content` responses shouldn't have Content-Length
 	*/
-	if (_headers.find("Content-Length") == _headers.end() && _statusCode != 204)
+	if (_chunked)
+	{
+		// Unknown-length body: the Connection frames fragments as
+		// chunks; Content-Length would contradict the framing
+	}
+	else if (!_headers.has("Content-Length") && _statusCode != 204)
 	{
-		ss << "Content-Length: " << _body.size() << "\r\n";
+		// File-backed bodies advertise the on-disk length
+		ss << "Content-Length: " << (_fileBody ? _fileLength : _body.size()) << "\r\n";
 	}
 
 	/*
@@ -480,14 +564,15 @@ void Response::buildIfNeeded() const
 	ss << "\r\n";
 
 	/*
-		BODY
-		The actual content being sent.
-		Can be text (HTML, JSON) or binary (images, files).
-		Size must match Content-Length header exactly.
-	*/
-	ss << _body;
+		NO BODY HERE
 
-	_builtResponse = ss.str();
+		The body is deliberately NOT appended. The Connection sends
+		the header block and the body as two iovecs with writev()
+		(or streams a file-backed body with sendfile()), so building
+		the classic headers+body string would just re-copy the whole
+		body to prepend a couple hundred bytes.
+	*/
+	_builtHeaders = ss.str();
 	_dirty = false;
 }
 
@@ -509,20 +594,31 @@ void Response::buildIfNeeded() const
 std::string Response::build() const
 {
 	buildIfNeeded();
-	return _builtResponse;
+	return _builtHeaders + _body;
 }
 
 /*
-	getData() - Get reference to built response
+	getHeaderData() - Serialized header block (no body)
 
-	More efficient than build() - returns const reference
-	instead of copying the string. Use this when sending
-	data through send() or write().
+	Const reference into the cached header string; see the
+	declaration for why the body is kept separate.
 */
-const std::string& Response::getData() const
+const std::string& Response::getHeaderData() const
 {
 	buildIfNeeded();
-	return _builtResponse;
+	return _builtHeaders;
+}
+
+/*
+	swapBody() - Steal the body without copying it
+
+	buildIfNeeded() runs first so the auto-generated Content-Length
+	is computed while the body is still here.
+*/
+void Response::swapBody(std::string& out)
+{
+	buildIfNeeded();
+	_body.swap(out);
 }
 
 /*
@@ -537,7 +633,7 @@ const std::string& Response::getData() const
 size_t Response::getSize() const
 {
 	buildIfNeeded();
-	return _builtResponse.size();
+	return _builtHeaders.size() + (_fileBody ? _fileLength : _body.size());
 }
 
 
@@ -563,17 +659,12 @@ const std::string& Response::getReasonPhraseValue() const
 /*
 	getHeader() - Get a specific header value
 
-	Returns the header value if found, empty string otherwise.
-	Useful for testing and debugging.
+	Returns the header value if found (case-insensitively), or a
+	shared empty string otherwise.
 */
-std::string Response::getHeader(const std::string& name) const
+const std::string& Response::getHeader(const std::string& name) const
 {
-	std::map<std::string, std::string>::const_iterator it = _headers.find(name);
-	if (it != _headers.end())
-	{
-		return it->second;
-	}
-	return "";
+	return _headers.get(name);
 }
 
 /*
@@ -583,7 +674,7 @@ std::string Response::getHeader(const std::string& name) const
 */
 bool Response::hasHeader(const std::string& name) const
 {
-	return _headers.find(name) != _headers.end();
+	return _headers.has(name);
 }
 
 bool Response::shouldKeepAlive() const
@@ -635,6 +726,18 @@ Response Response::ok(const std::string& body, const std::string& contentType)
 */
 std::string Response::getDefaultErrorPage(int code)
 {
+	/*
+		The page for a given code never changes, so build it once
+		and memoize - a 404 storm renders the HTML one time, not
+		once per response.
+	*/
+	static std::map<int, std::string> cache;
+	std::map<int, std::string>::const_iterator hit = cache.find(code);
+	if (hit != cache.end())
+	{
+		return hit->second;
+	}
+
 	std::ostringstream body;
 	body << "<!DOCTYPE html>\n";
 	body << "<html>\n";
@@ -655,7 +758,9 @@ std::string Response::getDefaultErrorPage(int code)
 	body << "    <p><small>webserv/1.0</small></p>\n";
 	body << "</body>\n";
 	body << "</html>\n";
-	return body.str();
+
+	cache[code] = body.str();
+	return cache[code];
 }
 
 
@@ -915,59 +1020,57 @@ bool Response::isTextFile(const std::string& filepath)
 */
 std::string Response::getMimeType(const std::string& extension)
 {
-	// Text types
-	if (extension == ".html" || extension == ".htm")
-		return "text/html; charset=UTF-8";
-	if (extension == ".css")
-		return "text/css; charset=UTF-8";
-	if (extension == ".js")
-		return "application/javascript; charset=UTF-8";
-	if (extension == ".json")
-		return "application/json; charset=UTF-8";
-	if (extension == ".xml")
-		return "application/xml; charset=UTF-8";
-	if (extension == ".txt")
-		return "text/plain; charset=UTF-8";
-
-	// Image types
-	if (extension == ".jpg" || extension == ".jpeg")
-		return "image/jpeg";
-	if (extension == ".png")
-		return "image/png";
-	if (extension == ".gif")
-		return "image/gif";
-	if (extension == ".ico")
-		return "image/x-icon";
-	if (extension == ".svg")
-		return "image/svg+xml";
-	if (extension == ".webp")
-		return "image/webp";
-
-	// Document types
-	if (extension == ".pdf")
-		return "application/pdf";
-	if (extension == ".zip")
-		return "application/zip";
-	if (extension == ".gz" || extension == ".gzip")
-		return "application/gzip";
-	if (extension == ".tar")
-		return "application/x-tar";
-
-	// Media types
-	if (extension == ".mp3")
-		return "audio/mpeg";
-	if (extension == ".mp4")
-		return "video/mp4";
-	if (extension == ".webm")
-		return "video/webm";
-
-	// Font types
-	if (extension == ".woff")
-		return "font/woff";
-	if (extension == ".woff2")
-		return "font/woff2";
-	if (extension == ".ttf")
-		return "font/ttf";
+	/*
+		The table is built exactly once (function-local static, same
+		trick as HeaderMap's interned name pool) and every later call
+		is a single map lookup. The old if-chain re-constructed up to
+		~25 temporary std::strings per call - per response, on the
+		hot static-file path.
+	*/
+	static std::map<std::string, std::string> table;
+	if (table.empty())
+	{
+		// Text types
+		table[".html"] = "text/html; charset=UTF-8";
+		table[".htm"] = "text/html; charset=UTF-8";
+		table[".css"] = "text/css; charset=UTF-8";
+		table[".js"] = "application/javascript; charset=UTF-8";
+		table[".json"] = "application/json; charset=UTF-8";
+		table[".xml"] = "application/xml; charset=UTF-8";
+		table[".txt"] = "text/plain; charset=UTF-8";
+
+		// Image types
+		table[".jpg"] = "image/jpeg";
+		table[".jpeg"] = "image/jpeg";
+		table[".png"] = "image/png";
+		table[".gif"] = "image/gif";
+		table[".ico"] = "image/x-icon";
+		table[".svg"] = "image/svg+xml";
+		table[".webp"] = "image/webp";
+
+		// Document types
+		table[".pdf"] = "application/pdf";
+		table[".zip"] = "application/zip";
+		table[".gz"] = "application/gzip";
+		table[".gzip"] = "application/gzip";
+		table[".tar"] = "application/x-tar";
+
+		// Media types
+		table[".mp3"] = "audio/mpeg";
+		table[".mp4"] = "video/mp4";
+		table[".webm"] = "video/webm";
+
+		// Font types
+		table[".woff"] = "font/woff";
+		table[".woff2"] = "font/woff2";
+		table[".ttf"] = "font/ttf";
+	}
+
+	std::map<std::string, std::string>::const_iterator it = table.find(extension);
+	if (it != table.end())
+	{
+		return it->second;
+	}
 
 	// Default for unknown types
 	// Will be determined by content analysis in getMimeTypeForFile()
@@ -14,9 +14,11 @@
 #include "Utils.hpp"
 #include "CGI.hpp"
 #include "Config.hpp"
+#include "Counters.hpp"
 
 #include <fstream>
 #include <sstream>
+#include <cstdio>		// rename() for spilled upload bodies
 #include <ctime>
 #include <algorithm>
 
@@ -84,20 +86,33 @@
 // Default Constructor
 // setConfig() must be called before routing requests
 // This pattern allows the Router to be created early and configured later
-Router::Router() : _config(NULL) {}
+Router::Router() : _config(NULL), _configGeneration(0), _autoindexCacheBytes(0) {}
 
 // Parametrized Constructor
 // Creates a Router with a reference to the server configuration
 // The Router does not own the Config - it just references it
 // The Config must remain valid for the Router's lifetime
-Router::Router(const Config& config) : _config(&config) {}
+Router::Router(const Config& config) : _config(&config), _configGeneration(0),
+	_autoindexCacheBytes(0)
+{
+	buildRouteIndex();
+}
 
 // Destructor
-// Nothing to clean up, we don't own the `config`
-Router::~Router() {}
+// We don't own the Config, but the routing index nodes are ours
+Router::~Router()
+{
+	clearRouteIndex();
+}
 
 // Copy Constructor
-Router::Router(const Router& other) : _config(other._config) {}
+// The file cache is deliberately NOT copied - a copy starts cold
+// rather than duplicating potentially megabytes of cached bodies.
+Router::Router(const Router& other) : _config(other._config),
+	_configGeneration(0), _autoindexCacheBytes(0), _fileCache()
+{
+	buildRouteIndex();	// Rebuilt from the config, not copied
+}
 
 // copy Assignment Operator
 Router& Router::operator=(const Router &other)
@@ -105,6 +120,11 @@ Router& Router::operator=(const Router &other)
 	if (this != &other)
 	{
 		_config = other._config;
+		++_configGeneration;	// The blocks behind old memos changed
+		buildRouteIndex();	// Rebuilt from the config, not copied
+		_fileCache.clear();	// Start cold, same as the copy constructor
+		_autoindexCache.clear();
+		_autoindexCacheBytes = 0;
 	}
 	return *this;
 }
@@ -125,6 +145,272 @@ Router& Router::operator=(const Router &other)
 void Router::setConfig(const Config& config)
 {
 	_config = &config;
+
+	// Invalidate per-connection memos of the previous config's blocks
+	++_configGeneration;
+
+	// Precompile the routing tables for the new config - route()
+	// then matches in O(path length) instead of scanning vectors
+	buildRouteIndex();
+
+	// A config swap may change roots, so entries keyed by resolved
+	// path could now point at the wrong files - start cold
+	_fileCache.clear();
+	_autoindexCache.clear();
+	_autoindexCacheBytes = 0;
+}
+
+
+unsigned long Router::getConfigGeneration() const
+{
+	return _configGeneration;
+}
+
+
+/*
+	prewarmCaches() - Pay the cold-start costs before traffic
+
+	Two passes over the active config:
+
+	1. Index files: each location's root/index is read into the
+	   hot-file cache with exactly the key serveDirectory() will look
+	   up (root without trailing slash + "/" + index), so the first
+	   "GET /" after a deploy is a pure memory hit. Files over the
+	   cache's per-file limit are skipped - they take the sendfile
+	   path anyway.
+
+	2. CGI interpreters: reading the first chunk of the binary faults
+	   it into the kernel page cache, so the first fork+exec doesn't
+	   stall on disk. (Existence and the execute bit were already
+	   enforced by Config::validateConfig().)
+
+	Purely best-effort: anything unreadable here is simply served the
+	cold way on first request, exactly as before.
+*/
+void Router::prewarmCaches()
+{
+	if (!_config)
+	{
+		return;
+	}
+
+	size_t warmedFiles = 0;
+	size_t touchedInterpreters = 0;
+	const std::vector<ServerConfig>& servers = _config->getServers();
+
+	for (size_t i = 0; i < servers.size(); ++i)
+	{
+		for (size_t j = 0; j < servers[i].locations.size(); ++j)
+		{
+			const LocationConfig& loc = servers[i].locations[j];
+
+			// Index file into the hot-file cache
+			if (!loc.root.empty() && !loc.index.empty())
+			{
+				std::string indexPath = loc.root;
+				if (indexPath[indexPath.length() - 1] == '/')
+				{
+					indexPath.erase(indexPath.length() - 1);
+				}
+				indexPath += "/" + loc.index;
+
+				struct stat fileStat;
+				if (_fileCache.get(indexPath) == NULL
+					&& stat(indexPath.c_str(), &fileStat) == 0
+					&& S_ISREG(fileStat.st_mode)
+					&& (size_t)fileStat.st_size <= CACHE_MAX_FILE_SIZE)
+				{
+					std::ifstream file(indexPath.c_str(), std::ios::binary);
+					if (file)
+					{
+						std::stringstream contents;
+						contents << file.rdbuf();
+						_fileCache.put(indexPath, contents.str(),
+										Response::getMimeTypeForFile(indexPath),
+										fileStat.st_mtime);
+						++warmedFiles;
+					}
+				}
+			}
+
+			// Interpreter binary into the page cache
+			if (!loc.cgi_path.empty())
+			{
+				int fd = open(loc.cgi_path.c_str(), O_RDONLY);
+				if (fd >= 0)
+				{
+					char buffer[4096];
+					if (read(fd, buffer, sizeof(buffer)) > 0)
+					{
+						++touchedInterpreters;
+					}
+					close(fd);
+				}
+			}
+		}
+	}
+
+	std::cout << "  Prewarmed " << warmedFiles << " index file(s), "
+			  << "touched " << touchedInterpreters
+			  << " CGI interpreter(s)" << std::endl;
+}
+
+
+/*
+	buildRouteIndex() - Precompile the routing tables
+
+	One pass over the parsed config at setConfig() time:
+
+	1. Server index: every (port, server_name) pair maps straight to
+	   its server block; (port, "") is the port's default (first
+	   declared, matching the old linear scan's tie-break).
+
+	2. Location prefix trees: each location path is split into
+	   segments and inserted into its server's tree. A config with
+	   200 location blocks previously cost 200 string compares per
+	   request; the tree costs one map lookup per path segment.
+
+	Duplicate names/paths keep the FIRST declaration, same as the
+	linear scans they replace.
+*/
+void Router::buildRouteIndex()
+{
+	clearRouteIndex();
+
+	if (!_config)
+	{
+		return;
+	}
+
+	const std::vector<ServerConfig>& servers = _config->getServers();
+
+	for (size_t i = 0; i < servers.size(); ++i)
+	{
+		const ServerConfig& server = servers[i];
+
+		// Default server for this port: first declared wins
+		std::pair<int, std::string> defaultKey(server.port, std::string());
+		if (_serverIndex.find(defaultKey) == _serverIndex.end())
+		{
+			_serverIndex[defaultKey] = &server;
+		}
+
+		// Named entries for virtual hosting
+		for (size_t j = 0; j < server.server_names.size(); ++j)
+		{
+			std::pair<int, std::string> key(server.port, server.server_names[j]);
+			if (_serverIndex.find(key) == _serverIndex.end())
+			{
+				_serverIndex[key] = &server;
+			}
+		}
+
+		/*
+			Preload custom error pages. Small HTML files, read once
+			here instead of once per error response - under crawler
+			traffic the 404 page is one of the hottest "assets" the
+			server has.
+		*/
+		for (std::map<int, std::string>::const_iterator ep = server.error_pages.begin();
+			 ep != server.error_pages.end(); ++ep)
+		{
+			const std::string& path = ep->second;
+			if (_errorPageCache.find(path) != _errorPageCache.end())
+			{
+				continue;	// Shared between codes/servers - load once
+			}
+			std::ifstream file(path.c_str());
+			if (file)
+			{
+				std::stringstream contents;
+				contents << file.rdbuf();
+				_errorPageCache[path] = contents.str();
+			}
+		}
+
+		// Location prefix tree for this server
+		RouteNode* root = new RouteNode();
+		_routeTrees[&server] = root;
+
+		for (size_t j = 0; j < server.locations.size(); ++j)
+		{
+			const LocationConfig& location = server.locations[j];
+			const std::string& path = location.path;
+			RouteNode* node = root;
+
+			// Walk/create one child per path segment ("/api/users"
+			// -> "api" -> "users"; "/" stays at the root)
+			size_t start = 0;
+			while (start < path.size())
+			{
+				while (start < path.size() && path[start] == '/')
+				{
+					++start;
+				}
+				size_t end = start;
+				while (end < path.size() && path[end] != '/')
+				{
+					++end;
+				}
+				if (end == start)
+				{
+					break;
+				}
+
+				std::string segment = path.substr(start, end - start);
+				std::map<std::string, RouteNode*>::iterator child =
+					node->children.find(segment);
+				if (child == node->children.end())
+				{
+					RouteNode* next = new RouteNode();
+					node->children[segment] = next;
+					node = next;
+				}
+				else
+				{
+					node = child->second;
+				}
+				start = end;
+			}
+
+			if (!node->location)
+			{
+				node->location = &location;
+			}
+		}
+	}
+}
+
+
+/*
+	clearRouteIndex() - Free the routing tables
+*/
+void Router::clearRouteIndex()
+{
+	_serverIndex.clear();
+
+	for (std::map<const ServerConfig*, RouteNode*>::iterator it = _routeTrees.begin();
+		 it != _routeTrees.end(); ++it)
+	{
+		freeRouteNode(it->second);
+	}
+	_routeTrees.clear();
+
+	_errorPageCache.clear();
+}
+
+
+/*
+	freeRouteNode() - Recursively free a prefix tree
+*/
+void Router::freeRouteNode(RouteNode* node)
+{
+	for (std::map<std::string, RouteNode*>::iterator it = node->children.begin();
+		 it != node->children.end(); ++it)
+	{
+		freeRouteNode(it->second);
+	}
+	delete node;
 }
 
 
@@ -165,7 +451,8 @@ void Router::setConfig(const Config& config)
 		5. Resolve path: root + /photo.jpg
 		6. Serve the file
 */
-Response Router::route(const Request& request, int serverPort)
+Response Router::route(const Request& request, int serverPort,
+						CgiExecution* asyncCgi, const ServerConfig* vhost)
 {
 	// Step 1: Validate config
 	if (!_config)
@@ -174,12 +461,25 @@ Response Router::route(const Request& request, int serverPort)
 		return errorResponse(500);
 	}
 
-	// Step 2: Find matching server block
-	// Get Host header for virtual hosting
-	std::string hostHeader = request.getHeader("Host");
+	/*
+		Reserved internal endpoint: live server counters. Checked
+		before virtual-host resolution so it answers on every vhost
+		and can never be shadowed by a location block or a file
+		that happens to share the name.
+	*/
+	if (request.getPath() == "/.webserv/status")
+	{
+		return statusResponse(request);
+	}
 
-	// Find server using both port AND hostname
-	const ServerConfig* server = findServer(serverPort, hostHeader);
+	// Step 2: Find matching server block. The caller usually hands
+	// us the Connection's memoized Host resolution; only resolve
+	// from the Host header when it doesn't (direct route() calls).
+	const ServerConfig* server = vhost;
+	if (!server)
+	{
+		server = findServer(serverPort, request.getHeader("Host"));
+	}
 	if (!server)
 	{
 		return errorResponse(500);
@@ -260,7 +560,7 @@ Response Router::route(const Request& request, int serverPort)
 	std::string resolvedPath = resolvePath(requestPath, *location);
 	if (isCgiRequest(resolvedPath, *location))
 	{
-		return handleCgi(request, resolvedPath, *location);
+		return handleCgi(request, resolvedPath, *location, asyncCgi);
 	}
 
 	// Step 7: Dispatch to method handler
@@ -272,11 +572,19 @@ Response Router::route(const Request& request, int serverPort)
 	*/
 	if (method == "GET" || method == "HEAD")
 	{
-		return handleGet(request, *location);
+		Response response = handleGet(request, *location);
+
+		// Compress eligible text responses on the way out
+		// (the precompressed .gz fast path inside handleGet() has
+		// already set Content-Encoding when it hit)
+		maybeCompress(request, *location, response);
+		return response;
 	}
 	else if (method == "POST")
 	{
-		return handlePost(request, *location);
+		Response response = handlePost(request, *location);
+		maybeCompress(request, *location, response);
+		return response;
 	}
 	else if (method == "DELETE")
 	{
@@ -308,92 +616,86 @@ const ServerConfig* Router::findServer(int port, const std::string& hostname) co
 	if (!_config)
 		return NULL;
 
-	const std::vector<ServerConfig>& servers = _config->getServers();
-	const ServerConfig* defaultServer = NULL;
-
 	// Extract hostname without port (Host header might be "example.com:8080")
 	std::string host = hostname;
 	size_t colonPos = host.find(':');
 	if (colonPos != std::string::npos)
 		host = host.substr(0, colonPos);
 
-	for (size_t i = 0; i < servers.size(); ++i)
+	// Exact (port, name) hit in the precompiled index
+	if (!host.empty())
 	{
-		if (servers[i].port != port)
-			continue;
-
-		// Check if this server matches the hostname
-		const std::vector<std::string>& names = servers[i].server_names;
-
-		for (size_t j = 0; j < names.size(); ++j)
-		{
-			if (names[j] == host)
-				return &servers[i];  // Exact match found
-		}
-
-		// Remember first server on this port as default
-		if (!defaultServer)
-			defaultServer = &servers[i];
+		std::map<std::pair<int, std::string>, const ServerConfig*>::const_iterator it =
+			_serverIndex.find(std::make_pair(port, host));
+		if (it != _serverIndex.end())
+			return it->second;
 	}
 
-	// No exact match - return default server for this port
-	return defaultServer;
+	// No exact match - the (port, "") entry is the default server
+	std::map<std::pair<int, std::string>, const ServerConfig*>::const_iterator def =
+		_serverIndex.find(std::make_pair(port, std::string()));
+	return (def != _serverIndex.end()) ? def->second : NULL;
 }
 
 /*
 	findLocation()  -  Find the best matching location for a URI path
 
+	Walks the server's precompiled prefix tree one path segment at a
+	time, remembering the deepest node that carries a location block.
+	Segment-wise descent gives path-boundary matching for free
+	("/api" matches "/api/users" but can never match "/apiary" - the
+	first segment "apiary" is simply a different map key), and
+	deepest-node-wins IS longest-prefix-match. Cost is one map
+	lookup per segment - O(path length), however many location
+	blocks the config declares.
+
 	Input: server, path
 	Return: best matching LocationConfig, or NULL if no match
 */
 const LocationConfig* Router::findLocation(const ServerConfig& server,
 											const std::string& path) const
 {
-	const LocationConfig *bestMatch = NULL;
-	size_t bestMatchLength = 0;
+	std::map<const ServerConfig*, RouteNode*>::const_iterator treeIt =
+		_routeTrees.find(&server);
+	if (treeIt == _routeTrees.end())
+	{
+		return NULL;
+	}
 
-	const std::vector<LocationConfig>& locations = server.locations;
+	const RouteNode* node = treeIt->second;
+	const LocationConfig* bestMatch = node->location;	// "location /" lives at the root
 
-	for (size_t i = 0; i < locations.size(); i++)
+	size_t start = 0;
+	while (start < path.size())
 	{
-		std::string locationPath = locations[i].path;
-
-		// Normalize: remove trailing slash from location for comparison
-		// "/directory/" becomes "/directory" for matching purposes
-		std::string normalizedLocation = locationPath;
-		if (normalizedLocation.length() > 1 &&
-			normalizedLocation[normalizedLocation.length() - 1] == '/')
+		// Skip slashes (also collapses "//" and trailing "/")
+		while (start < path.size() && path[start] == '/')
+		{
+			++start;
+		}
+		size_t end = start;
+		while (end < path.size() && path[end] != '/')
 		{
-			normalizedLocation = normalizedLocation.substr(0, normalizedLocation.length() - 1);
+			++end;
+		}
+		if (end == start)
+		{
+			break;
 		}
 
-		// Also normalize request path
-		std::string normalizedPath = path;
-		if (normalizedPath.length() > 1 &&
-			normalizedPath[normalizedPath.length() - 1] == '/')
+		std::map<std::string, RouteNode*>::const_iterator child =
+			node->children.find(path.substr(start, end - start));
+		if (child == node->children.end())
 		{
-			normalizedPath = normalizedPath.substr(0, normalizedPath.length() - 1);
+			break;	// No deeper location - the best so far stands
 		}
 
-		// Check if location path is a prefix of the request path
-		if (normalizedPath.compare(0, normalizedLocation.length(), normalizedLocation) == 0)
+		node = child->second;
+		if (node->location)
 		{
-			// Additional check: ensure we match at path boundary
-			// "/api" should NOT match "/apiary"
-			// it should match: "/api", "/api/", "/api/users"
-			if (normalizedPath.length() == normalizedLocation.length() ||	// Exact match
-				normalizedPath[normalizedLocation.length()] == '/' ||		// Prefix match
-				normalizedLocation == "/")									// Root always matches
-			{
-				// Use original location path length for specificity
-				// (but normalized length for comparison)
-				if (normalizedLocation.length() > bestMatchLength)
-				{
-					bestMatch = &locations[i];
-					bestMatchLength = normalizedLocation.length();
-				}
-			}
+			bestMatch = node->location;
 		}
+		start = end;
 	}
 
 	return bestMatch;
@@ -559,12 +861,16 @@ Response Router::handleGet(const Request& request, const LocationConfig& locatio
 	// Check if it's a directory
 	if (S_ISDIR(pathStat.st_mode))
 	{
-		response = serveDirectory(path, location);
+		response = serveDirectory(path, location, &request);
+	}
+	else if (tryPrecompressed(request, path, location, response))
+	{
+		// Served the sibling .gz - nothing more to do here
 	}
 	else
 	{
 		// It's a file - serve it
-		response = serveFile(path);
+		response = serveFile(path, &request);
 	}
 
 	// For HEAD requests, keep headers but remove body
@@ -708,6 +1014,40 @@ Response Router::handlePost(const Request& request, const LocationConfig& locati
 	std::string contentType = request.getHeader("Content-Type");
 	std::string contentTypeLower = Utils::toLower(contentType);
 
+	/*
+		Spilled bodies (>= BODY_SPILL_THRESHOLD, see Request.hpp):
+		the body lives in a temp file, request.getBody() is empty.
+
+		- Raw uploads (step 4C) never load it: the temp file is
+		  rename()d straight into the upload directory, so memory
+		  stays flat no matter how large the upload is.
+		- multipart/urlencoded parsing still needs the bytes in
+		  memory; those bodies are read back here. Streaming
+		  multipart parsing is future work - note that such bodies
+		  were rejected outright (413 at 1 MB) before spilling
+		  existed, so this is strictly more capable.
+	*/
+	std::string reloadedBody;
+	const std::string* bodyPtr = &request.getBody();
+	if (request.isBodyInFile()
+		&& !Utils::startsWith(contentTypeLower, "application/octet-stream")
+		&& (Utils::startsWith(contentTypeLower, "multipart/form-data")
+			|| Utils::startsWith(contentTypeLower,
+									"application/x-www-form-urlencoded")))
+	{
+		std::ifstream bodyFile(request.getBodyFilePath().c_str(),
+								std::ios::binary);
+		if (!bodyFile)
+		{
+			return errorResponse(500);
+		}
+		std::stringstream bodyStream;
+		bodyStream << bodyFile.rdbuf();
+		reloadedBody = bodyStream.str();
+		bodyPtr = &reloadedBody;
+	}
+	const std::string& body = *bodyPtr;
+
 	/*
 		Step 4A: Handle multipart/form-data (file uploads)
 		--------------------------------------------------
@@ -732,7 +1072,7 @@ Response Router::handlePost(const Request& request, const LocationConfig& locati
 		}
 
 		// Parse the multipart body into individual parts
-		std::vector<MultipartPart> parts = Utils::parseMultipart(request.getBody(), boundary);
+		std::vector<MultipartPart> parts = Utils::parseMultipart(body, boundary);
 
 		if (parts.empty())
 		{
@@ -858,7 +1198,7 @@ Response Router::handlePost(const Request& request, const LocationConfig& locati
 	{
 		// Parse the form data
 		std::map<std::string, std::string> formData =
-											Utils::parseFormUrlEncoded(request.getBody());
+											Utils::parseFormUrlEncoded(body);
 
 		// For now, just acknowledge receipt
 		// A real implementation would do something with formData
@@ -894,8 +1234,9 @@ Response Router::handlePost(const Request& request, const LocationConfig& locati
 	*/
 	else
 	{
-		// Check if body is empty
-		if (request.getBody().empty())
+		// Check if body is empty (spilled bodies have an empty
+		// in-memory string - count the bytes, not the string)
+		if (request.getBodySize() == 0)
 		{
 			return errorResponse(400);  // Bad Request - empty body
 		}
@@ -930,22 +1271,58 @@ Response Router::handlePost(const Request& request, const LocationConfig& locati
 		savePath += filenameStream.str();
 
 		// Save the file
-		std::ofstream outFile(savePath.c_str(), std::ios::binary);
-		if (!outFile)
+		if (request.isBodyInFile())
 		{
-			return errorResponse(500);
-		}
+			/*
+				Spilled body: the bytes are already on disk in the
+				parser's temp file. rename() moves it into the upload
+				directory in O(1) - the body is never loaded into
+				memory at all. If /tmp and the upload dir are on
+				different filesystems rename() fails with EXDEV and
+				we fall back to a bounded-buffer copy.
+			*/
+			if (rename(request.getBodyFilePath().c_str(),
+						savePath.c_str()) != 0)
+			{
+				std::ifstream src(request.getBodyFilePath().c_str(),
+									std::ios::binary);
+				std::ofstream dst(savePath.c_str(), std::ios::binary);
+				if (!src || !dst)
+				{
+					return errorResponse(500);
+				}
 
-		outFile.write(request.getBody().c_str(), request.getBody().length());
+				char copyBuf[65536];
+				while (src.read(copyBuf, sizeof(copyBuf)) || src.gcount() > 0)
+				{
+					dst.write(copyBuf, src.gcount());
+				}
 
-		if (outFile.fail())
+				if (dst.fail())
+				{
+					return errorResponse(500);
+				}
+			}
+		}
+		else
 		{
+			std::ofstream outFile(savePath.c_str(), std::ios::binary);
+			if (!outFile)
+			{
+				return errorResponse(500);
+			}
+
+			outFile.write(body.c_str(), body.length());
+
+			if (outFile.fail())
+			{
+				outFile.close();
+				return errorResponse(500);
+			}
+
 			outFile.close();
-			return errorResponse(500);
 		}
 
-		outFile.close();
-
 		// Success response
 		Response response;
 		response.setStatus(201, "Created");
@@ -1076,51 +1453,438 @@ Response Router::handleDelete(const Request& request, const LocationConfig& loca
 // ===============================
 
 /*
-	serveFile()  -  Read and return a file's contents
+	Files at or above this size are served file-backed via sendfile()
+	(see Response::setFileBody). Below it, the cost of reading into
+	memory is negligible and a single send() of headers + body wins.
+*/
+static const size_t SENDFILE_THRESHOLD = 64 * 1024;  // 64 KB
+
+/*
+	acceptsGzip()  -  Does the request allow gzip encoding?
+
+	A loose contains-check on Accept-Encoding is what every major
+	server does in practice; clients that send "gzip;q=0" are rare
+	enough not to special-case.
+*/
+bool Router::acceptsGzip(const Request& request) const
+{
+	std::string accept = Utils::toLower(request.getHeader("Accept-Encoding"));
+	return accept.find("gzip") != std::string::npos;
+}
+
+
+/*
+	isCompressibleMime()  -  Is this MIME type worth compressing?
+
+	Text-like types shrink 5-10x under gzip. Images, video and
+	archives are already compressed - gzipping them burns CPU to
+	make them slightly LARGER.
+*/
+static bool isCompressibleMime(const std::string& mime)
+{
+	return Utils::startsWith(mime, "text/")
+		|| Utils::startsWith(mime, "application/json")
+		|| Utils::startsWith(mime, "application/javascript")
+		|| Utils::startsWith(mime, "application/xml")
+		|| Utils::startsWith(mime, "image/svg+xml");
+}
+
+
+/*
+	tryPrecompressed()  -  Serve a sibling .gz file for hot assets
+
+	The zero-CPU path: if /app.js.gz exists next to /app.js, serve
+	its bytes directly (sendfile and the hot-file cache both apply)
+	while advertising the ORIGINAL MIME type plus Content-Encoding:
+	gzip. Build pipelines regenerate the .gz alongside the asset.
+*/
+bool Router::tryPrecompressed(const Request& request, const std::string& path,
+								const LocationConfig& location, Response& response)
+{
+	if (!location.gzip || !acceptsGzip(request))
+	{
+		return false;
+	}
+
+	std::string gzPath = path + ".gz";
+
+	struct stat gzStat;
+	if (stat(gzPath.c_str(), &gzStat) != 0 || !S_ISREG(gzStat.st_mode))
+	{
+		return false;	// No precompressed sibling
+	}
+
+	// NULL request: the gz sibling is a different representation -
+	// its validators/ranges would not describe what the client asked
+	// for, so conditionals apply only on the identity path
+	response = serveFile(gzPath, NULL);
+	if (response.getStatusCode() != 200)
+	{
+		return false;	// Vanished between stat() and open - fall back
+	}
+
+	// The client asked for /app.js, not a gzip file: advertise the
+	// original type and mark the encoding
+	response.setContentType(Response::getMimeTypeForFile(path));
+	response.setHeader("Content-Encoding", "gzip");
+	response.setHeader("Vary", "Accept-Encoding");
+	return true;
+}
+
+
+/*
+	maybeCompress()  -  Gzip an eligible response body in place
+
+	Cheap rejects first (flag, client support, body mode, size,
+	MIME) so the common case costs a couple of compares. When
+	compression applies, the body is replaced and Content-Length
+	updated; "Vary: Accept-Encoding" tells caches to key on the
+	client's encoding support.
+*/
+void Router::maybeCompress(const Request& request, const LocationConfig& location,
+							Response& response)
+{
+	// Minimum body size worth compressing: below this the gzip
+	// header/trailer overhead eats the savings
+	static const size_t GZIP_MIN_SIZE = 256;
+
+	if (!location.gzip || !acceptsGzip(request))
+	{
+		return;
+	}
+	if (response.getStatusCode() != 200)
+	{
+		return;	// Error pages are tiny; redirects have no real body
+	}
+	if (response.hasFileBody() || response.isChunked())
+	{
+		return;	// sendfile/chunked bodies never pass through memory
+	}
+	if (response.hasHeader("Content-Encoding"))
+	{
+		return;	// Already encoded (precompressed .gz path)
+	}
+
+	const std::string& body = response.getBody();
+	if (body.size() < GZIP_MIN_SIZE)
+	{
+		return;
+	}
+
+	if (!isCompressibleMime(response.getHeader("Content-Type")))
+	{
+		return;
+	}
+
+	std::string compressed;
+	if (!Utils::gzipCompress(body, compressed)
+		|| compressed.size() >= body.size())
+	{
+		return;	// zlib failed or the body didn't shrink - send as-is
+	}
+
+	response.setBody(compressed);
+	response.setContentLength(compressed.size());
+	response.setHeader("Content-Encoding", "gzip");
+	response.setHeader("Vary", "Accept-Encoding");
+}
+
+
+/*
+	serveFile()  -  Return a file's contents
 
 	Process:
-	1. Open the file
-	2. Read contents into memory
-	3. Determine Content-Type from extension
-	4. Build response with appropiriate headers
+	1. stat() the file for size
+	2. Large file: file-backed response, streamed with sendfile()
+	   (zero userspace copies, never blocks the event loop reading)
+	3. Small file: read contents into memory as before
+	4. Determine Content-Type from extension
+	5. Build response with appropiriate headers
 
 	Input:
 		filepath:	Absolute path to the file
 	Return:
 		Response with file contents and appropriate headers
 */
-Response Router::serveFile(const std::string& filepath)
+/*
+	notModified() - see the declaration in Router.hpp
+*/
+bool Router::notModified(const Request& request, const std::string& etag,
+							const std::string& lastModified)
+{
+	const std::string& ifNoneMatch = request.getHeader("If-None-Match");
+
+	if (!ifNoneMatch.empty())
+	{
+		if (ifNoneMatch == "*")
+		{
+			return true;
+		}
+
+		// Comma-separated list of (possibly weak) entity tags
+		size_t pos = 0;
+		while (pos < ifNoneMatch.size())
+		{
+			size_t comma = ifNoneMatch.find(',', pos);
+			if (comma == std::string::npos)
+			{
+				comma = ifNoneMatch.size();
+			}
+
+			std::string tag = ifNoneMatch.substr(pos, comma - pos);
+
+			// Trim surrounding spaces and any W/ weak prefix - a weak
+			// match is fine for cache validation (RFC 7232 section 3.2)
+			size_t start = tag.find_first_not_of(" \t");
+			size_t end = tag.find_last_not_of(" \t");
+			if (start != std::string::npos)
+			{
+				tag = tag.substr(start, end - start + 1);
+				if (tag.compare(0, 2, "W/") == 0)
+				{
+					tag = tag.substr(2);
+				}
+				if (tag == etag)
+				{
+					return true;
+				}
+			}
+
+			pos = comma + 1;
+		}
+
+		// If-None-Match was present: it takes precedence, and nothing
+		// matched, so the client's copy is stale
+		return false;
+	}
+
+	// Fall back to If-Modified-Since - exact match against the
+	// Last-Modified we emitted (clients echo it back verbatim)
+	const std::string& ifModifiedSince = request.getHeader("If-Modified-Since");
+	return !ifModifiedSince.empty() && ifModifiedSince == lastModified;
+}
+
+
+/*
+	notModifiedResponse() - Empty 304 carrying the current validators
+
+	File-local helper: the 304 must repeat ETag/Last-Modified so the
+	client can refresh its cache metadata without re-downloading.
+*/
+static Response notModifiedResponse(const std::string& etag,
+									const std::string& lastModified)
+{
+	Response response;
+	response.setStatus(304, "Not Modified");
+	response.setHeader("ETag", etag);
+	response.setHeader("Last-Modified", lastModified);
+	response.setBody("");
+	response.addStandardHeaders();
+	return response;
+}
+
+
+/*
+	rangeNotSatisfiableResponse() - 416 with the actual file size
+
+	"Content-Range: bytes *<slash>size" tells the client how big the
+	resource really is, so a stale resume offset can restart cleanly.
+*/
+static Response rangeNotSatisfiableResponse(size_t fileSize)
+{
+	Response response;
+	response.setStatus(416, "Range Not Satisfiable");
+
+	std::ostringstream contentRange;
+	contentRange << "bytes */" << fileSize;
+	response.setHeader("Content-Range", contentRange.str());
+	response.setBody("");
+	response.addStandardHeaders();
+	return response;
+}
+
+
+/*
+	wantsRange() - Should this request's Range header be honored?
+
+	If-Range guards a resume against the file changing underneath it:
+	when present and NOT matching the current ETag, the range must be
+	ignored and the full (new) file served instead.
+*/
+static bool wantsRange(const Request& request, const std::string& etag)
 {
-	// Open file for reading in binary mode
-	std::ifstream file(filepath.c_str(), std::ios::binary);
-	if (!file)
+	const std::string& ifRange = request.getHeader("If-Range");
+	return ifRange.empty() || ifRange == etag;
+}
+
+
+Response Router::serveFile(const std::string& filepath, const Request* request)
+{
+	/*
+		Hot-file cache lookup FIRST - before any syscall.
+
+		For a fresh cache entry this costs one map lookup: no stat(),
+		no open(), no read. index.html fetched thousands of times per
+		second is served entirely from memory. Stale entries (mtime
+		changed on disk) are dropped by the cache itself and we fall
+		through to the disk path below, which re-populates it.
+	*/
+	const FileCacheEntry* cached = _fileCache.get(filepath);
+	if (cached != NULL)
+	{
+		// Client already holds this version? 304 beats even a
+		// memory-to-memory copy
+		if (request != NULL
+			&& notModified(*request, cached->etag, cached->lastModified))
+		{
+			return notModifiedResponse(cached->etag, cached->lastModified);
+		}
+
+		Response response;
+		response.setStatus(200, "OK");
+		response.setContentType(cached->mimeType);
+		response.setHeader("ETag", cached->etag);
+		response.setHeader("Last-Modified", cached->lastModified);
+		response.setHeader("Accept-Ranges", "bytes");
+
+		size_t offset = 0;
+		size_t length = 0;
+		Request::RangeResult rangeResult = Request::RANGE_NONE;
+		if (request != NULL && wantsRange(*request, cached->etag))
+		{
+			rangeResult = request->getByteRange(cached->body.size(),
+												offset, length);
+		}
+
+		if (rangeResult == Request::RANGE_UNSATISFIABLE)
+		{
+			return rangeNotSatisfiableResponse(cached->body.size());
+		}
+		if (rangeResult == Request::RANGE_VALID)
+		{
+			std::ostringstream contentRange;
+			contentRange << "bytes " << offset << "-"
+						 << (offset + length - 1) << "/"
+						 << cached->body.size();
+			response.setStatus(206, "Partial Content");
+			response.setHeader("Content-Range", contentRange.str());
+			response.setContentLength(length);
+			response.setBody(cached->body.substr(offset, length));
+		}
+		else
+		{
+			response.setContentLength(cached->body.size());
+			response.setBody(cached->body);
+		}
+
+		response.addStandardHeaders();
+		return response;
+	}
+
+	// Get the file size (and confirm it still exists)
+	struct stat fileStat;
+	if (stat(filepath.c_str(), &fileStat) != 0 || !S_ISREG(fileStat.st_mode))
 	{
 		return errorResponse(404);
 	}
 
-	// Read entire file into string
-	std::stringstream contents;
-	contents << file.rdbuf();
-	file.close();
+	// Validators: same "size-mtime" (hex) recipe the file cache uses,
+	// so a file served from disk and later from cache keeps its ETag
+	std::stringstream etagStream;
+	etagStream << "\"" << std::hex << (size_t)fileStat.st_size
+			   << "-" << fileStat.st_mtime << "\"";
+	std::string etag = etagStream.str();
+	std::string lastModified = Response::formatHttpDate(fileStat.st_mtime);
+
+	if (request != NULL && notModified(*request, etag, lastModified))
+	{
+		return notModifiedResponse(etag, lastModified);
+	}
+
+	size_t fileSize = (size_t)fileStat.st_size;
+
+	size_t offset = 0;
+	size_t length = 0;
+	Request::RangeResult rangeResult = Request::RANGE_NONE;
+	if (request != NULL && wantsRange(*request, etag))
+	{
+		rangeResult = request->getByteRange(fileSize, offset, length);
+	}
 
-	// Determine Content-Type from file extension
-	std::string extension;
-	size_t dotPos = filepath.rfind('.');
-	if (dotPos != std::string::npos)
+	if (rangeResult == Request::RANGE_UNSATISFIABLE)
 	{
-		extension = filepath.substr(dotPos);
+		return rangeNotSatisfiableResponse(fileSize);
 	}
 
 	// Use getMimeTypeForFile for content-based detection
 	std::string contentType = Response::getMimeTypeForFile(filepath);
-	std::string body = contents.str();
 
-	// Build response
 	Response response;
 	response.setStatus(200, "OK");
 	response.setContentType(contentType);
-	response.setContentLength(body.size());  // Explicitly set Content-Length
-	response.setBody(body);
+	response.setHeader("ETag", etag);
+	response.setHeader("Last-Modified", lastModified);
+	response.setHeader("Accept-Ranges", "bytes");
+
+	if (rangeResult == Request::RANGE_VALID)
+	{
+		std::ostringstream contentRange;
+		contentRange << "bytes " << offset << "-" << (offset + length - 1)
+					 << "/" << fileSize;
+		response.setStatus(206, "Partial Content");
+		response.setHeader("Content-Range", contentRange.str());
+	}
+	else
+	{
+		// Full file
+		offset = 0;
+		length = fileSize;
+	}
+
+	if (fileSize >= SENDFILE_THRESHOLD)
+	{
+		/*
+			Large file: don't read it at all. The Response just
+			records (path, offset, length); the Connection streams
+			it with sendfile() straight from the kernel page cache.
+			The old path copied a 500 MB download four times
+			(ifstream -> _body -> _builtResponse -> _writeBuffer)
+			and blocked the event loop while reading. A 206 resume
+			is the same mechanism with a non-zero starting offset -
+			the skipped prefix is never touched.
+		*/
+		response.setContentLength(length);
+		response.setFileBody(filepath, offset, length);
+	}
+	else
+	{
+		// Small file: read it into memory in one go
+		std::ifstream file(filepath.c_str(), std::ios::binary);
+		if (!file)
+		{
+			return errorResponse(404);
+		}
+
+		std::stringstream contents;
+		contents << file.rdbuf();
+		file.close();
+
+		std::string body = contents.str();
+		response.setContentLength(length);  // Explicitly set Content-Length
+		if (rangeResult == Request::RANGE_VALID)
+		{
+			response.setBody(body.substr(offset, length));
+		}
+		else
+		{
+			response.setBody(body);
+		}
+
+		// Remember the FULL file for next time (no-op if over the
+		// size cap) - the next range request slices from memory
+		_fileCache.put(filepath, body, contentType, fileStat.st_mtime);
+	}
+
 	response.addStandardHeaders();
 
 	return response;
@@ -1167,7 +1931,8 @@ Response Router::serveFile(const std::string& filepath)
 		- 200 OK + directory listing HTML (if autoindex enabled)
 		- 403 Forbidden (if no index and autoindex disabled)
 */
-Response Router::serveDirectory(const std::string& dirpath, const LocationConfig& location)
+Response Router::serveDirectory(const std::string& dirpath, const LocationConfig& location,
+								const Request* request)
 {
 	/*
 		Step 1: Try to serve index file
@@ -1195,7 +1960,7 @@ Response Router::serveDirectory(const std::string& dirpath, const LocationConfig
 		if (stat(indexPath.c_str(), &indexStat) == 0 && S_ISREG(indexStat.st_mode))
 		{
 			// Index file exists! Serve it instead of directory listing
-			return serveFile(indexPath);
+			return serveFile(indexPath, request);
 		}
 	}
 
@@ -1215,6 +1980,33 @@ Response Router::serveDirectory(const std::string& dirpath, const LocationConfig
 		return errorResponse(404);  // changed from 403 Forbidden to 404 Not Found
 	}
 
+	/*
+		Step 2b: Listing cache lookup
+		-----------------------------
+		One stat() on the directory replaces the full opendir() +
+		stat()-per-entry scan when the directory hasn't changed.
+		Adding, removing or renaming an entry bumps the directory's
+		mtime, which invalidates the cached HTML (see the member doc
+		in Router.hpp for what this key does NOT catch).
+	*/
+	struct stat dirStatCheck;
+	bool haveDirMtime = (stat(dirpath.c_str(), &dirStatCheck) == 0);
+	if (haveDirMtime)
+	{
+		std::map<std::string, AutoindexEntry>::const_iterator it =
+			_autoindexCache.find(dirpath);
+		if (it != _autoindexCache.end()
+			&& it->second.mtime == dirStatCheck.st_mtime)
+		{
+			Response response;
+			response.setStatus(200, "OK");
+			response.setContentType("text/html; charset=UTF-8");
+			response.setBody(it->second.html);
+			response.addStandardHeaders();
+			return response;
+		}
+	}
+
 	/*
 		Step 3: Open the directory
 		--------------------------
@@ -1499,14 +2291,41 @@ Response Router::serveDirectory(const std::string& dirpath, const LocationConfig
 	html << "</html>\n";
 
 	/*
-		Step 7: Build HTTP Response
-		---------------------------
-		Return a 200 OK response with the generated HTML.
+		Step 7: Cache the listing and build the HTTP Response
+		-----------------------------------------------------
+		The HTML is stored under the mtime observed BEFORE the scan -
+		if the directory changed mid-scan, the stored mtime is
+		already stale and the next hit regenerates.
+		A simple total-bytes cap keeps a burst of huge listings from
+		pinning memory: when exceeded the whole cache is dropped and
+		rebuilt on demand (listings regenerate themselves; there is
+		nothing to lose but time).
 	*/
+	static const size_t AUTOINDEX_CACHE_MAX_BYTES = 4 * 1024 * 1024;	// 4 MB
+
+	std::string htmlStr = html.str();
+
+	if (haveDirMtime)
+	{
+		if (_autoindexCacheBytes + htmlStr.size() > AUTOINDEX_CACHE_MAX_BYTES)
+		{
+			_autoindexCache.clear();
+			_autoindexCacheBytes = 0;
+		}
+		if (htmlStr.size() <= AUTOINDEX_CACHE_MAX_BYTES)
+		{
+			AutoindexEntry& entry = _autoindexCache[dirpath];
+			_autoindexCacheBytes -= entry.html.size();	// Replacing an entry
+			entry.mtime = dirStatCheck.st_mtime;
+			entry.html = htmlStr;
+			_autoindexCacheBytes += htmlStr.size();
+		}
+	}
+
 	Response response;
 	response.setStatus(200, "OK");
 	response.setContentType("text/html; charset=UTF-8");
-	response.setBody(html.str());
+	response.setBody(htmlStr);
 	response.addStandardHeaders();
 
 	return response;
@@ -1676,7 +2495,8 @@ std::string Router::formatTime(time_t timestamp)
 		504 - Gateway Timeout (script took too long)
 */
 Response Router::handleCgi(const Request& request, const std::string& scriptPath,
-													const LocationConfig& location)
+													const LocationConfig& location,
+													CgiExecution* asyncCgi)
 {
 	// =========================================
 	//  Step 8.1: Setup CGI
@@ -1708,6 +2528,62 @@ Response Router::handleCgi(const Request& request, const std::string& scriptPath
 		return errorResponse(errorCode);
 	}
 
+	// =========================================
+	//  Asynchronous path (epoll-driven)
+	// =========================================
+	/*
+		If the caller gave us a CgiExecution slot, launch the child
+		with startAsync() and hand the pipe fds back instead of
+		blocking here. The Server registers them in its epoll set,
+		feeds the body / collects the output incrementally, and calls
+		finishCgi() once the script is done. The Response we return
+		here is a placeholder the caller must ignore.
+
+		This is the normal production path - the blocking execute()
+		below only runs when no slot is provided (unit-style direct
+		calls to route()).
+	*/
+	if (asyncCgi)
+	{
+		/*
+			Worker cap (cgi_workers directive): bound how many
+			interpreter processes run concurrently. Above the cap we
+			don't fork at all - the caller queues the request and
+			retries when a running script finishes. This keeps a
+			burst of CGI traffic from turning into a fork storm the
+			way a fixed FastCGI pool of N workers would.
+		*/
+		if (asyncCgi->activeCount >= location.cgi_workers)
+		{
+			asyncCgi->deferred = true;
+			return Response();
+		}
+
+		CGI::AsyncExec exec;
+		if (!cgi.startAsync(exec))
+		{
+			return errorResponse(500);
+		}
+
+		asyncCgi->started = true;
+		asyncCgi->maxOutput = location.cgi_max_output;
+		asyncCgi->pid = exec.pid;
+		asyncCgi->stdinFd = exec.stdinFd;
+		asyncCgi->stdoutFd = exec.stdoutFd;
+		if (request.isBodyInFile())
+		{
+			// Spilled body: hand over the file path so the Server can
+			// stream it to the script's stdin chunk by chunk instead
+			// of pulling the whole upload back into memory
+			asyncCgi->bodyFile = request.getBodyFilePath();
+		}
+		else
+		{
+			asyncCgi->body = cgi.getRequestBody();
+		}
+		return Response();
+	}
+
 	// =========================================
 	//  Step 8.2: Execute CGI
 	// =========================================
@@ -1725,6 +2601,89 @@ Response Router::handleCgi(const Request& request, const std::string& scriptPath
 	const int CGI_TIMEOUT = 30;  // seconds
 	CGI::CGIResult cgiResult = cgi.execute(CGI_TIMEOUT);
 
+	return cgiResultToResponse(cgiResult);
+}
+
+/*
+	finishCgi()  -  Build the final Response for an async CGI request
+
+	The Server calls this after the epoll loop has collected the
+	complete stdout of an async CGI child (EOF on the stdout pipe).
+	We parse the raw output here so the Response-building logic lives
+	in one place, shared with the synchronous handleCgi() path.
+
+	Input:
+		rawOutput: Everything the script wrote to stdout
+
+	Returns:
+		Response from the CGI output, or an error response:
+		500 - script produced no output at all
+		502 - output malformed (no header/body separator)
+*/
+Response Router::finishCgi(const std::string& rawOutput)
+{
+	CGI::CGIResult result;
+
+	if (rawOutput.empty())
+	{
+		result.success = false;
+		result.statusCode = 500;
+		result.errorMessage = "CGI script produced no output";
+	}
+	else
+	{
+		CGI::parseOutput(rawOutput, result);
+	}
+
+	return cgiResultToResponse(result);
+}
+
+/*
+	startCgiStream()  -  Begin a chunked response from CGI headers
+
+	The mirror of finishCgi() for streaming: only the header block
+	exists yet, so the Response advertises Transfer-Encoding: chunked
+	instead of a Content-Length and carries no body. First-byte
+	latency for long-running scripts drops from "when the script
+	exits" to "when it prints its headers".
+*/
+Response Router::startCgiStream(const std::string& headerBlock)
+{
+	CGI::CGIResult result;
+
+	if (!CGI::parseOutput(headerBlock, result) || !result.success)
+	{
+		// Malformed header block - hand back a plain Response so the
+		// caller keeps buffering and the EOF path reports the error
+		return Response();
+	}
+
+	Response response;
+	response.setStatus(result.statusCode);
+
+	// Copy headers from the script (Content-Length, if the script
+	// sent one, is dropped by setChunked() - it cannot coexist with
+	// chunked framing)
+	std::map<std::string, std::string>::const_iterator it;
+	for (it = result.headers.begin(); it != result.headers.end(); ++it)
+	{
+		response.setHeader(it->first, it->second);
+	}
+
+	response.setChunked();
+	response.addStandardHeaders();
+	return response;
+}
+
+
+/*
+	cgiResultToResponse()  -  Convert a CGIResult into an HTTP Response
+
+	Shared by handleCgi() (synchronous) and finishCgi() (async) so
+	both paths produce identical responses and error pages.
+*/
+Response Router::cgiResultToResponse(const CGI::CGIResult& cgiResult)
+{
 	// =========================================
 	//  Handle execution failure
 	// =========================================
@@ -1805,6 +2764,41 @@ Response Router::handleCgi(const Request& request, const std::string& scriptPath
 	Returns:
 		Error response ready to send
 */
+/*
+	statusResponse() - Render the Counters for /.webserv/status
+
+	Default is JSON; "?format=prometheus" switches to the Prometheus
+	text exposition format so a scraper can point straight at the
+	server. The counters are plain in-process integers, so building
+	the body is the only cost - no locks, no syscalls beyond send.
+*/
+Response Router::statusResponse(const Request& request)
+{
+	if (request.getMethod() != "GET")
+	{
+		return errorResponse(405);
+	}
+
+	Response response;
+	response.setStatus(200);
+
+	// No caching: every scrape should see live numbers
+	response.setHeader("Cache-Control", "no-store");
+
+	if (request.getQueryString().find("format=prometheus") != std::string::npos)
+	{
+		response.setContentType("text/plain; version=0.0.4");
+		response.setBody(Counters::toPrometheus());
+	}
+	else
+	{
+		response.setContentType("application/json");
+		response.setBody(Counters::toJson());
+	}
+	return response;
+}
+
+
 Response Router::errorResponse(int code, const ServerConfig* server)
 {
 	// Check for custom error page
@@ -1813,21 +2807,20 @@ Response Router::errorResponse(int code, const ServerConfig* server)
 		std::map<int, std::string>::const_iterator it = server->error_pages.find(code);
 		if (it != server->error_pages.end())
 		{
-			// Custom error page configured
-			std::string errorPagePath = it->second;
-
-			// Try to serve the custom error page
-			std::ifstream file(errorPagePath.c_str());
-			if (file)
+			/*
+				Custom error page configured - serve the body cached
+				at buildRouteIndex() time. No disk I/O per error: if
+				the file wasn't readable at startup there is no cache
+				entry and we fall through to the built-in page.
+			*/
+			std::map<std::string, std::string>::const_iterator cached =
+				_errorPageCache.find(it->second);
+			if (cached != _errorPageCache.end())
 			{
-				std::stringstream contents;
-				contents << file.rdbuf();
-				file.close();
-
 				Response response;
 				response.setStatus(code);
 				response.setContentType("text/html");
-				response.setBody(contents.str());
+				response.setBody(cached->second);
 				return response;
 			}
 		}
@@ -15,6 +15,11 @@
 #include "Request.hpp"
 #include "Response.hpp"
 #include "Router.hpp"
+#include "Logger.hpp"
+#include "Stats.hpp"
+#include "Counters.hpp"
+
+#include <algorithm>	// std::sort for enforceMemoryBudget()
 
 /*
 	=================================================================
@@ -137,7 +142,18 @@
 // setConfig() should be called before init() for this to work.
 Server::Server() : _config(NULL),
 				   _running(false),
-				   _epollFd(-1)
+				   _epollFd(-1),
+				   _connectionCount(0),
+				   _acceptedTotal(0),
+				   _acceptBatchMax(0),
+				   _listenOverflowsBase(0),
+				   _listenDropsBase(0),
+				   _ipCapRejects(0),
+				   _reloadPending(0),
+				   _workerId(0),
+				   _activeCgiCount(0),
+				   _timerWheel(TIMER_WHEEL_SIZE),
+				   _lastWheelTick(0)
 {
 }
 
@@ -146,7 +162,18 @@ Server::Server() : _config(NULL),
 // must remain valid for the lifetime of the Server.
 Server::Server(const Config &config) : _config(&config),
 									   _running(false),
-									   _epollFd(-1)
+									   _epollFd(-1),
+									   _connectionCount(0),
+									   _acceptedTotal(0),
+									   _acceptBatchMax(0),
+									   _listenOverflowsBase(0),
+									   _listenDropsBase(0),
+									   _ipCapRejects(0),
+									   _reloadPending(0),
+									   _workerId(0),
+									   _activeCgiCount(0),
+									   _timerWheel(TIMER_WHEEL_SIZE),
+									   _lastWheelTick(0)
 {
 }
 
@@ -164,6 +191,14 @@ Server::Server(const Config &config) : _config(&config),
 Server::~Server()
 {
 	stop();
+
+	// Free every config snapshot we created via SIGHUP reloads
+	// (retired snapshots included - see performConfigReload())
+	for (size_t i = 0; i < _ownedConfigs.size(); ++i)
+	{
+		delete _ownedConfigs[i];
+	}
+	_ownedConfigs.clear();
 }
 
 // =================================================================
@@ -181,6 +216,138 @@ Server::~Server()
 void Server::setConfig(const Config &config)
 {
 	_config = &config;
+	_router.setConfig(config);
+}
+
+
+/*
+	requestReload() - Flag a config reload from the SIGHUP handler
+
+	Only sets a sig_atomic_t - the handler must not allocate, parse
+	files or touch the Router. run() notices the flag on its next
+	iteration (epoll_wait returns EINTR on the signal, so "next
+	iteration" is immediate).
+*/
+void Server::requestReload()
+{
+	_reloadPending = 1;
+}
+
+
+/*
+	performConfigReload() - Zero-downtime configuration swap
+
+	The nginx reload model, scaled down to one process:
+
+	1. Re-parse the original config file into a FRESH Config object.
+	   A syntax error aborts the reload - the running snapshot is
+	   never touched by a half-parsed file.
+	2. Swap the Server's config pointer and rebuild the Router's
+	   precompiled tables from the new snapshot. Single-threaded, so
+	   the swap happens between two loop iterations: responses in
+	   flight (including parked CGI clients) drain on whatever they
+	   already resolved, every request routed after this line uses
+	   the new config. No listener is closed, no connection dropped,
+	   and the file cache restarts cold (roots may have moved).
+	3. Re-point each ListenSocket at its matching new server block
+	   and re-apply the process-wide log level / stats toggle.
+
+	The OLD snapshot is retired, not freed: startup config is owned
+	by main(), reloaded ones stay in _ownedConfigs until shutdown
+	(see the member doc in Server.hpp).
+
+	Listen directives are the one thing a live reload cannot change:
+	we keep serving on the sockets bound at startup and say so,
+	rather than rebinding and dropping the connections the reload is
+	meant to preserve.
+*/
+void Server::performConfigReload()
+{
+	if (!_config)
+	{
+		return;
+	}
+
+	const std::string path = _config->getConfigPath();
+	std::cout << "\n=== Reloading configuration (worker " << _workerId
+			  << "): " << path << " ===" << std::endl;
+
+	// Step 1: parse into a fresh snapshot - failure leaves the
+	// running config untouched
+	Config* fresh = new Config();
+	try
+	{
+		fresh->parseFile(path);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Config reload FAILED, keeping current config: "
+				  << e.what() << std::endl;
+		Logger::error(std::string("Config reload failed: ") + e.what());
+		delete fresh;
+		return;
+	}
+
+	// Warn about listen changes we won't apply (see doc above)
+	const std::vector<ServerConfig>& newServers = fresh->getServers();
+	for (size_t i = 0; i < newServers.size(); ++i)
+	{
+		bool bound = false;
+		for (size_t j = 0; j < _listenSockets.size(); ++j)
+		{
+			if (_listenSockets[j].port == newServers[i].port)
+			{
+				bound = true;
+				break;
+			}
+		}
+		if (!bound)
+		{
+			std::cout << "  Note: new listen directive "
+					  << newServers[i].host << ":" << newServers[i].port
+					  << " requires a restart to take effect" << std::endl;
+		}
+	}
+
+	// Step 2: the swap - everything after this routes on the new
+	// snapshot
+	_ownedConfigs.push_back(fresh);
+	_config = fresh;
+	_router.setConfig(*fresh);
+
+	// The swap emptied every cache - warm the new config's index
+	// files before the next request pays the cold path
+	_router.prewarmCaches();
+
+	// Step 3: re-point listeners and re-apply process-wide settings
+	for (size_t i = 0; i < _listenSockets.size(); ++i)
+	{
+		const ServerConfig* match = fresh->getServerByHostPort(
+			_listenSockets[i].host, _listenSockets[i].port);
+		if (match)
+		{
+			_listenSockets[i].serverConfig = match;
+		}
+		// No match: the old snapshot stays valid (retired, not freed)
+	}
+
+	if (!newServers.empty())
+	{
+		LogLevel level = LOG_INFO;
+		if (!newServers[0].log_level.empty())
+		{
+			Logger::parseLevel(newServers[0].log_level, level);
+		}
+		Logger::setLevel(level);
+		Stats::setEnabled(newServers[0].stats);
+		// access_log path changes need a restart - swapping the log
+		// fd mid-run is not worth racing the buffered writer
+	}
+
+	std::cout << "=== Configuration reloaded: " << newServers.size()
+			  << " server block(s), " << _connectionCount
+			  << " connection(s) carried over ===" << std::endl;
+	Logger::info("Configuration reloaded from " + path);
 }
 
 // =================================================================
@@ -235,12 +402,55 @@ bool Server::init()
 		return false;
 	}
 
+	// Point the long-lived Router at the configuration, then pay the
+	// cold-start costs (index files, interpreter binaries) up front
+	// so the first request after startup doesn't pay them
+	_router.setConfig(*_config);
+	_router.prewarmCaches();
+
+	/*
+		Configure the buffered Logger. The Logger is process-wide
+		(one log stream per worker), so the first server block's
+		access_log / log_level settings apply to all of them -
+		like an http-level directive in nginx.
+	*/
+	{
+		LogLevel level = LOG_INFO;
+		if (!servers[0].log_level.empty())
+		{
+			Logger::parseLevel(servers[0].log_level, level);
+		}
+		Logger::init(servers[0].access_log, level);
+		Stats::setEnabled(servers[0].stats);
+		Counters::startTime = time(NULL);
+	}
+
 	std::cout << "\n=== Initializing Server ===" << std::endl;
 	std::cout << "Found " << servers.size() << " server block(s) in configuration\n"
 			  << std::endl;
 
 	// =========================================
-	//  Step 2: Create Listening Sockets
+	//  Step 2: Prefork Workers (if configured)
+	// =========================================
+	/*
+		Fork BEFORE creating the listening sockets. Each worker then
+		binds its OWN sockets with SO_REUSEPORT, so the kernel gives
+		every worker a private accept queue and load-balances incoming
+		connections across them by flow hash. This avoids the classic
+		"thundering herd" of many processes blocking in accept() on
+		one shared socket: exactly one worker is woken per connection.
+	*/
+	if (_config->getWorkerProcesses() > 1)
+	{
+		if (!spawnWorkers(_config->getWorkerProcesses()))
+		{
+			std::cerr << "Error: Failed to spawn worker processes" << std::endl;
+			return false;
+		}
+	}
+
+	// =========================================
+	//  Step 3: Create Listening Sockets
 	// =========================================
 	/*
 		Track which host:port combinations we've already created
@@ -297,8 +507,10 @@ bool Server::init()
 	}
 
 	// =========================================
-	//  Step 3: Initialize Epoll
+	//  Step 4: Initialize Epoll
 	// =========================================
+	// Each worker creates its own epoll instance here - the event
+	// loops are fully independent, no state is shared after fork().
 	if (!initEpoll())
 	{
 		std::cerr << "Error: Failed to initialize epoll" << std::endl;
@@ -307,9 +519,9 @@ bool Server::init()
 	}
 
 	// =========================================
-	//  Step 4: Report Success
+	//  Step 5: Report Success
 	// =========================================
-	std::cout << "\n=== Server Initialized ===" << std::endl;
+	std::cout << "\n=== Server Initialized (worker " << _workerId << ") ===" << std::endl;
 	std::cout << "Listening on " << _listenSockets.size() << " socket(s):" << std::endl;
 
 	for (size_t i = 0; i < _listenSockets.size(); ++i)
@@ -321,9 +533,106 @@ bool Server::init()
 	std::cout << "\nEpoll fd=" << _epollFd << " initialized" << std::endl;
 	std::cout << std::endl;
 
+	// Baseline for the kernel's listen-queue drop counters; stop()
+	// reports the delta accumulated while this server was running
+	readListenQueueStats(_listenOverflowsBase, _listenDropsBase);
+
+	return true;
+}
+
+// =================================================================
+//  WORKER PROCESSES (SO_REUSEPORT PREFORK MODE)
+// =================================================================
+
+/*
+	spawnWorkers() - Prefork worker processes
+
+	The master process forks (count - 1) children. Each child keeps
+	running init() from the point of the fork, so it creates its own
+	listening sockets (bound with SO_REUSEPORT) and its own epoll
+	instance. Nothing is shared between workers - no locks, no
+	descriptor passing - the kernel does all the load balancing.
+
+	Process layout with worker_processes 4:
+
+		master (workerId 0)  ── also serves traffic
+		├── child (workerId 1)
+		├── child (workerId 2)
+		└── child (workerId 3)
+
+	Children inherit the signal handlers installed in main(), so a
+	SIGTERM from the master triggers the same graceful stop() path
+	a Ctrl+C would in single-process mode.
+
+	Parameters:
+		count: Total number of workers (including the master)
+
+	Returns: true on success, false if fork() failed
+*/
+bool Server::spawnWorkers(int count)
+{
+	std::cout << "--- Preforking " << count << " worker(s) ---" << std::endl;
+
+	for (int i = 1; i < count; ++i)
+	{
+		pid_t pid = fork();
+
+		if (pid < 0)
+		{
+			std::cerr << "fork() failed: " << strerror(errno) << std::endl;
+			reapWorkers();	// Kill any children we already created
+			return false;
+		}
+
+		if (pid == 0)
+		{
+			// Child: remember who we are and continue with our own
+			// socket + epoll setup. Children never manage siblings.
+			_workerId = i;
+			_workerPids.clear();
+			return true;
+		}
+
+		// Parent: track the child for shutdown
+		_workerPids.push_back(pid);
+		std::cout << "  Worker " << i << " started (pid=" << pid << ")" << std::endl;
+	}
+
 	return true;
 }
 
+/*
+	reapWorkers() - Terminate and reap worker children
+
+	Master-only. SIGTERM lets each child run its own graceful
+	shutdown (close connections, epoll, sockets), then waitpid()
+	collects the exit status so no zombies are left behind.
+*/
+void Server::reapWorkers()
+{
+	for (size_t i = 0; i < _workerPids.size(); ++i)
+	{
+		kill(_workerPids[i], SIGTERM);
+	}
+
+	for (size_t i = 0; i < _workerPids.size(); ++i)
+	{
+		int status;
+		if (waitpid(_workerPids[i], &status, 0) > 0)
+		{
+			std::cout << "  Worker reaped (pid=" << _workerPids[i] << ")" << std::endl;
+		}
+	}
+
+	_workerPids.clear();
+}
+
+int Server::getWorkerId() const
+{
+	return _workerId;
+}
+
+
 // =================================================================
 //  EPOLL INITIALIZATION (Step 2.2)
 // =================================================================
@@ -663,6 +972,14 @@ void Server::run()
 	// =========================================
 	while (_running)
 	{
+		// SIGHUP arrived? Parse and swap the config here, on the
+		// loop thread, where no request is mid-flight
+		if (_reloadPending)
+		{
+			_reloadPending = 0;
+			performConfigReload();
+		}
+
 		/*
 			epoll_wait(epfd, events, maxevents, timeout)
 
@@ -707,10 +1024,12 @@ void Server::run()
 			break;
 		}
 
-		// Log event count (useful for debugging, can be removed later)
+		// Per-event chatter goes through the buffered Logger at
+		// debug level - at the default 'info' level the hot loop
+		// does no formatting and no I/O at all
 		if (numEvents > 0)
 		{
-			std::cout << "[epoll] " << numEvents << " event(s) ready" << std::endl;
+			LOG_DEBUG("[epoll] " << numEvents << " event(s) ready");
 		}
 
 		// =========================================
@@ -721,17 +1040,12 @@ void Server::run()
 			int fd = events[i].data.fd;
 			uint32_t eventMask = events[i].events;
 
-			// Log the event (for debugging)
-			std::cout << "  Event on fd=" << fd << ": ";
-			if (eventMask & EPOLLIN)
-				std::cout << "EPOLLIN ";
-			if (eventMask & EPOLLOUT)
-				std::cout << "EPOLLOUT ";
-			if (eventMask & EPOLLERR)
-				std::cout << "EPOLLERR ";
-			if (eventMask & EPOLLHUP)
-				std::cout << "EPOLLHUP ";
-			std::cout << std::endl;
+			// Log the event (debug level only)
+			LOG_DEBUG("  Event on fd=" << fd << ":"
+						<< ((eventMask & EPOLLIN) ? " EPOLLIN" : "")
+						<< ((eventMask & EPOLLOUT) ? " EPOLLOUT" : "")
+						<< ((eventMask & EPOLLERR) ? " EPOLLERR" : "")
+						<< ((eventMask & EPOLLHUP) ? " EPOLLHUP" : ""));
 
 			// -----------------------------------------
 			//  Case 1: Event on a LISTENING socket
@@ -752,7 +1066,7 @@ void Server::run()
 					int clientFd = acceptNewConnection(fd);
 					if (clientFd >= 0)
 					{
-						std::cout << "  -> Accepted new client fd=" << clientFd << std::endl;
+						LOG_DEBUG("  -> Accepted new client fd=" << clientFd);
 					}
 				}
 
@@ -764,7 +1078,21 @@ void Server::run()
 				}
 			}
 			// -----------------------------------------
-			//  Case 2: Event on a CLIENT socket
+			//  Case 2: Event on a CGI pipe
+			// -----------------------------------------
+			else if (isCgiFd(fd))
+			{
+				/*
+					A CGI child's stdin/stdout pipe is ready. These are
+					registered by processRequest() when a request routes
+					to CGI - feeding the body and collecting the output
+					happens here, chunk by chunk, without ever blocking
+					the loop on a slow script.
+				*/
+				handleCgiEvent(fd, eventMask);
+			}
+			// -----------------------------------------
+			//  Case 3: Event on a CLIENT socket
 			// -----------------------------------------
 			else
 			{
@@ -787,10 +1115,24 @@ void Server::run()
 		// =========================================
 		//  Periodic Cleanup
 		// =========================================
+		// Reap exited CGI children every tick (cheap: WNOHANG on a
+		// usually-empty list) so zombies never accumulate
+		reapCgiChildren();
+
+		// Expire idle connections: touches only the wheel slots that
+		// became due since the last tick, not the whole map
+		advanceTimerWheel();
+
+		enforceMemoryBudget();
+
+		// Batched log write: at most one write() per loop iteration,
+		// and only when the buffer is big or old enough (see Logger)
+		Logger::maybeFlush();
+
 		time_t now = time(NULL);
 		if (now - lastCleanup >= CLEANUP_INTERVAL_SEC)
 		{
-			cleanupTimedOutConnections();
+			cleanupTimedOutCgis();
 			lastCleanup = now;
 		}
 	}
@@ -805,100 +1147,226 @@ void Server::run()
 // =================================================================
 
 /*
-	acceptNewConnection() - Accept an incoming client connection
+	acceptNewConnection() - Drain the accept queue in one wakeup
 
 	Called when a listening socket has EPOLLIN (connection waiting).
 
-	The accept() call:
-	------------------
-	accept(sockfd, addr, addrlen)
-
-	Parameters:
-		sockfd:  Listening socket
-		addr:    Where to store client's address
-		addrlen: Size of addr buffer (in/out parameter)
+	The accept4() call:
+	-------------------
+	accept4(sockfd, addr, addrlen, SOCK_NONBLOCK)
 
-	Returns:
-		>= 0: New socket FD for this client
-		-1:   Error (check errno)
+	Same as accept(), but the new socket is born non-blocking -
+	saving the F_GETFL/F_SETFL fcntl() pair we used to issue per
+	connection through setNonBlocking().
 
-	IMPORTANT: The returned socket is a NEW file descriptor.
-	The original listening socket continues to listen.
+	Why a loop:
+	-----------
+	One EPOLLIN wakeup can stand for MANY queued connections. The
+	old one-accept-per-wakeup code relied on level-triggered epoll
+	re-reporting the socket, which meant a full epoll_wait round
+	trip per pending client; during arrival bursts the accept queue
+	(backlog 128) overflowed and the kernel silently dropped SYNs.
+	Looping until EAGAIN drains the whole queue the moment we wake.
 
-	We then:
-	1. Set the new socket to non-blocking mode
-	2. Add it to epoll for monitoring
-	3. Store client info for tracking
+	The burst counters this maintains - plus the kernel's
+	ListenOverflows/ListenDrops sampled in init() and reported in
+	stop() - make those drops visible (see readListenQueueStats()).
 
 	Parameters:
-		listenFd: The listening socket with pending connection
+		listenFd: The listening socket with pending connection(s)
 
 	Returns:
-		>= 0: Client socket FD
-		-1:   Error (connection not accepted)
+		>= 0: FD of the last client accepted in this batch
+		-1:   No connection was accepted
 */
 int Server::acceptNewConnection(int listenFd)
 {
-	// Prepare to store client's address
-	struct sockaddr_in clientAddr;
-	socklen_t clientLen = sizeof(clientAddr);
+	// Get server port from listen socket (same for the whole batch)
+	const ListenSocket* listenSock = getListenSocketByFd(listenFd);
+	int serverPort = listenSock ? listenSock->port : 0;
 
-	/*
-		accept() creates a new connected socket
+	unsigned long batch = 0;
+	int lastFd = -1;
 
-		The new socket:
-		- Has its own file descriptor
-		- Is connected to the specific client
-		- Inherits some properties from listening socket
+	while (true)
+	{
+		// Prepare to store client's address
+		struct sockaddr_in clientAddr;
+		socklen_t clientLen = sizeof(clientAddr);
 
-		The listening socket:
-		- Continues listening for more connections
-		- Is not affected by this call
-	*/
-	int clientFd = accept(listenFd, (struct sockaddr*)&clientAddr, &clientLen);
+		int clientFd = accept4(listenFd, (struct sockaddr*)&clientAddr,
+								&clientLen, SOCK_NONBLOCK);
 
-	if (clientFd < 0)
-	{
-		// EAGAIN/EWOULDBLOCK = no connection ready (normal in non-blocking mode)
-		if (errno == EAGAIN || errno == EWOULDBLOCK)
+		if (clientFd < 0)
+		{
+			// EAGAIN/EWOULDBLOCK = queue drained (normal exit path)
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+			{
+				break;
+			}
+			if (errno == EINTR)
+			{
+				continue;	// Interrupted by a signal, retry
+			}
+
+			std::cerr << "accept4() failed: " << strerror(errno) << std::endl;
+			break;
+		}
+
+		/*
+			Per-IP connection cap (see MAX_CONNS_PER_IP).
+
+			Checked BEFORE the Connection is created: a rejected client
+			costs one inet_ntop(), one map lookup and one close() - no
+			heap allocation, no epoll registration, no timer entry. The
+			cap is what keeps a single-source Slowloris flood from
+			exhausting the fd table; the phase-aware timeouts below
+			handle the connections that do get in.
+		*/
+		char ipBuffer[INET_ADDRSTRLEN];
+		inet_ntop(AF_INET, &clientAddr.sin_addr, ipBuffer, INET_ADDRSTRLEN);
+		std::map<std::string, int>::iterator ipIt = _ipConnCount.find(ipBuffer);
+		if (ipIt != _ipConnCount.end() && ipIt->second >= MAX_CONNS_PER_IP)
 		{
-			return -1;  // Not an error, just no connection ready
+			++_ipCapRejects;
+			LOG_DEBUG("  Rejected connection from " << ipBuffer
+						<< " (per-IP cap of " << MAX_CONNS_PER_IP
+						<< " reached)");
+			close(clientFd);
+			continue;	// Keep draining - other IPs may be queued behind
 		}
 
-		std::cerr << "accept() failed: " << strerror(errno) << std::endl;
-		return -1;
-	}
+		/*
+			Add to epoll - armed ONCE for the connection's whole life.
+			In edge-triggered mode both directions are registered up
+			front and never modified again: read/write interest lives
+			in the Connection state machine, not in the kernel, which
+			saves two epoll_ctl() syscalls per keep-alive request. A
+			spurious EPOLLOUT while we are parsing a request is a
+			no-op (nothing buffered to send), and ET means a
+			permanently writable socket fires only on transitions, not
+			on every epoll_wait().
+		*/
+		uint32_t clientEvents = EPOLLIN | CLIENT_TRIGGER_MODE;
+		if (CLIENT_TRIGGER_MODE != 0)
+		{
+			clientEvents |= EPOLLOUT;
+		}
+		if (!addToEpoll(clientFd, clientEvents))
+		{
+			std::cerr << "Failed to add client to epoll" << std::endl;
+			close(clientFd);
+			continue;	// This client is lost; keep draining the queue
+		}
 
-	// Get server port from listen socket
-	const ListenSocket* listenSock = getListenSocketByFd(listenFd);
-	int serverPort = listenSock ? listenSock->port : 0;
+		// Create the Connection in its fd-indexed slot.
+		// Heap-allocated exactly once - the old map insert copied the
+		// whole object (buffers included) into the tree.
+		if ((size_t)clientFd >= _connTable.size())
+		{
+			_connTable.resize(clientFd + 1, NULL);
+		}
+		Connection* conn = new Connection(clientFd, clientAddr, serverPort);
+		_connTable[clientFd] = conn;
+		++_connectionCount;
+		++_ipConnCount[conn->getClientIP()];
+
+		/*
+			Arm the timeout in the timer wheel (O(1) insert; renewal on
+			activity happens lazily when the slot fires). A fresh
+			connection gets the HEADER budget, not the full keep-alive
+			window - see Connection::getTimeoutDeadline(). The wheel
+			entry is re-checked against the CURRENT phase deadline when
+			it fires, so one entry per connection is enough even as the
+			connection moves between phases.
+		*/
+		scheduleTimeout(clientFd, conn->getTimeoutDeadline(
+			CONNECTION_TIMEOUT_SEC, HEADER_TIMEOUT_SEC, BODY_TIMEOUT_SEC));
+
+		LOG_DEBUG("  New connection from " << conn->getClientIP()
+					<< ":" << conn->getClientPort()
+					<< " (fd=" << clientFd << ", total: "
+					<< _connectionCount << ")");
+
+		++batch;
+		++_acceptedTotal;
+		++Counters::accepted;
+		++Counters::activeConnections;
+		lastFd = clientFd;
+	}
 
-	// Set non-blocking
-	if (!setNonBlocking(clientFd))
+	if (batch > _acceptBatchMax)
 	{
-		std::cerr << "Failed to set client socket non-blocking" << std::endl;
-		close(clientFd);
-		return -1;
+		_acceptBatchMax = batch;
+	}
+	if (batch > 1)
+	{
+		LOG_DEBUG("  Accepted " << batch << " connections in one wakeup");
 	}
 
-	// Add to epoll (initially monitor for EPOLLIN - waiting for request)
-	if (!addToEpoll(clientFd, EPOLLIN))
+	return lastFd;
+}
+
+
+/*
+	readListenQueueStats() - Parse the kernel's listen-queue counters
+
+	/proc/net/netstat carries the TcpExt counters as a header line
+	followed by a value line:
+
+		TcpExt: SyncookiesSent ... ListenOverflows ListenDrops ...
+		TcpExt: 0 ... 12 15 ...
+
+	ListenOverflows counts SYNs that arrived while an accept queue
+	was full; ListenDrops counts connections dropped outright. They
+	are system-wide and monotonic, which is why callers sample a
+	baseline first and report the delta.
+*/
+bool Server::readListenQueueStats(unsigned long& overflows, unsigned long& drops)
+{
+	std::ifstream file("/proc/net/netstat");
+	if (!file.is_open())
 	{
-		std::cerr << "Failed to add client to epoll" << std::endl;
-		close(clientFd);
-		return -1;
+		return false;	// Not Linux, or /proc not mounted
 	}
 
-	// Create and store Connection object
-	Connection conn(clientFd, clientAddr, serverPort);
-	_connections[clientFd] = conn;
+	std::string headerLine;
+	std::string valueLine;
+	while (std::getline(file, headerLine))
+	{
+		if (headerLine.compare(0, 7, "TcpExt:") != 0)
+		{
+			continue;
+		}
+		if (!std::getline(file, valueLine))
+		{
+			return false;
+		}
 
-	std::cout << "  New connection from " << conn.getClientIP()
-			  << ":" << conn.getClientPort()
-			  << " (fd=" << clientFd << ", total: " << _connections.size() << ")"
-			  << std::endl;
+		// Walk header and value lines in lock-step
+		std::istringstream names(headerLine);
+		std::istringstream values(valueLine);
+		std::string name;
+		std::string value;
+		bool foundOverflows = false;
+		bool foundDrops = false;
 
-	return clientFd;
+		while ((names >> name) && (values >> value))
+		{
+			if (name == "ListenOverflows")
+			{
+				overflows = std::strtoul(value.c_str(), NULL, 10);
+				foundOverflows = true;
+			}
+			else if (name == "ListenDrops")
+			{
+				drops = std::strtoul(value.c_str(), NULL, 10);
+				foundDrops = true;
+			}
+		}
+		return foundOverflows && foundDrops;
+	}
+	return false;
 }
 
 
@@ -919,15 +1387,15 @@ int Server::acceptNewConnection(int listenFd)
 */
 bool Server::handleClientEvent(int clientFd, uint32_t events)
 {
-	// Find connection info
-	std::map<int, Connection>::iterator it = _connections.find(clientFd);
-	if (it == _connections.end())
+	// Find connection info - O(1) slot lookup, no tree walk
+	Connection* connPtr = getConnection(clientFd);
+	if (!connPtr)
 	{
 		std::cerr << "Unknown client fd=" << clientFd << std::endl;
 		return false;
 	}
 
-	Connection& conn = it->second;
+	Connection& conn = *connPtr;
 
 	// =========================================
 	//  Handle Errors and Disconnection
@@ -940,10 +1408,9 @@ bool Server::handleClientEvent(int clientFd, uint32_t events)
 	*/
 	if (events & (EPOLLERR | EPOLLHUP))
 	{
-		std::cout << "  Client fd=" << clientFd;
-		if (events & EPOLLERR) std::cout << " error";
-		if (events & EPOLLHUP) std::cout << " hung up";
-		std::cout << std::endl;
+		LOG_DEBUG("  Client fd=" << clientFd
+					<< ((events & EPOLLERR) ? " error" : "")
+					<< ((events & EPOLLHUP) ? " hung up" : ""));
 		return false;  // Close connection
 	}
 
@@ -959,47 +1426,143 @@ bool Server::handleClientEvent(int clientFd, uint32_t events)
 			return false;
 		}
 
-		// Check if we have a complete request
-		if (conn.hasCompleteRequest())
+		// Check if we have a complete request.
+		// The state guard matters for CONN_CGI_WAIT: the request is
+		// already complete and handed to a CGI child - re-processing
+		// it here would fork a second script for the same request.
+		if (conn.hasCompleteRequest() && conn.getState() == CONN_READING)
 		{
 			// Process the request and generate response
 			processRequest(conn);
+
+			/*
+				HTTP/1.1 pipelining: if the client sent several
+				requests back-to-back, route ALL the complete ones
+				now. setResponse() queues each response behind the
+				previous one, so the whole batch leaves in one
+				writev() train instead of one round-trip each.
+			*/
+			while (conn.nextPipelinedRequest())
+			{
+				processRequest(conn);
+			}
 		}
 	}
 
 	// =========================================
-	//  Handle Writable (EPOLLOUT)
+	//  Handle Writable (eager)
 	// =========================================
-	if (events & EPOLLOUT)
+	/*
+		Send whenever there is something to send, not only on
+		EPOLLOUT. The fd is armed once with both directions (see
+		acceptNewConnection), so a response queued by the EPOLLIN
+		branch above produces no event of its own - the socket was
+		writable the whole time. EPOLLOUT still matters: it is the
+		drain edge that resumes a transfer parked on a full kernel
+		buffer.
+	*/
+	if ((events & EPOLLOUT) || conn.getState() == CONN_WRITING)
 	{
-		if (conn.hasDataToWrite())
+		bool hadData = conn.hasDataToWrite();
+
+		if (!flushClientWrites(conn))
 		{
-			if (!conn.writeData())
-			{
-				// Write failed
-				return false;
-			}
+			return false;
+		}
+
+		if (hadData)
+		{
+			// A draining client may be what a paused CGI stream is
+			// waiting for (see the streaming backpressure)
+			resumePausedCgi(clientFd);
 		}
 	}
 
 	// =========================================
-	//  Update Epoll Events if State Changed
+	//  Check Final Connection State
 	// =========================================
-	uint32_t neededEvents = conn.getNeededEvents();
-
-	if (neededEvents == 0)
+	if (conn.getNeededEvents() == 0)
 	{
 		// Connection should be closed
 		return false;
 	}
 
-	// Update epoll to monitor the right events
-	modifyEpoll(clientFd, neededEvents);
-
+	/*
+		No epoll_ctl here. The interest mask never changes after
+		accept: both loops above drain to EAGAIN, so there is no
+		level state left to re-arm, and the next edge (new request
+		bytes, or the kernel buffer draining) wakes us by itself.
+		This used to be an unconditional EPOLL_CTL_MOD - two
+		syscalls of pure re-arming per keep-alive request.
+	*/
 	return true;  // keep connection open
 }
 
 
+/*
+	flushClientWrites() - Push queued response bytes out now
+
+	The sending half of the event loop, shared by handleClientEvent()
+	and every CGI path that queues bytes on a parked connection
+	(stream start, chunk frames, completion). Writes until done or
+	EAGAIN; when a response completes and reset() carried over
+	pipelined requests that were parked behind it, routes them and
+	sends those responses too - no new network data will arrive to
+	wake us for bytes we already hold.
+*/
+bool Server::flushClientWrites(Connection& conn)
+{
+	for (;;)
+	{
+		if (conn.getState() == CONN_WRITING && conn.hasDataToWrite())
+		{
+			// One sample per flush: how long the writev()/sendfile()
+			// batch took, kernel buffer drain included
+			unsigned long writeStart = Stats::enabled() ? Stats::nowUs() : 0;
+			bool writeOk = conn.writeData();
+			if (Stats::enabled())
+			{
+				Stats::record(Stats::STAGE_WRITE, Stats::nowUs() - writeStart);
+			}
+			if (!writeOk)
+			{
+				// Write failed
+				return false;
+			}
+			if (conn.hasDataToWrite())
+			{
+				// Kernel buffer full - the EPOLLOUT drain edge
+				// resumes this transfer
+				break;
+			}
+		}
+
+		// Response complete: route pipelined requests carried over
+		// by reset(), then loop to send what they queued
+		if (conn.getState() == CONN_READING && conn.hasCompleteRequest())
+		{
+			processRequest(conn);
+
+			while (conn.nextPipelinedRequest())
+			{
+				processRequest(conn);
+			}
+			continue;
+		}
+
+		break;
+	}
+
+	if (CLIENT_TRIGGER_MODE == 0)
+	{
+		// Level-triggered fallback still re-arms the mask per state
+		modifyEpoll(conn.getFd(), conn.getNeededEvents());
+	}
+
+	return conn.getNeededEvents() != 0;
+}
+
+
 /*
 	processRequest() - Route request and generate response
 
@@ -1025,32 +1588,169 @@ void Server::processRequest(Connection& conn)
 	// Set client IP from connection (for CGI REMOTE_ADDR)
 	request->setClientIP(conn.getClientIP());
 
-	std::cout << "  Processing: " << request->getMethod() << " "
-			  << request->getPath() << std::endl;
+	LOG_DEBUG("  Processing: " << request->getMethod() << " "
+				<< request->getPath());
+
+	++Counters::requests;
 
 	// Check for parsing errors
 	if (request->hasError())
 	{
 		Response errorResp = Response::error(request->getErrorCode());
+		Logger::access(conn.getClientIP(), request->getMethod(),
+						request->getUri(), request->getHttpVersion(),
+						errorResp.getStatusCode(), errorResp.getSize());
 		conn.setResponse(errorResp);
 		return;
 	}
 
-	// Route the request
+	// Route the request through the long-lived Router
+	// (persistent so its hot-file cache survives between requests)
 	if (_config)
 	{
-		Router router(*_config);
-		Response response = router.route(*request, conn.getServerPort());
-		conn.setResponse(response);
-	}
-	else
-	{
-		// No config - send error
-		Response errorResp = Response::error(500);
-		conn.setResponse(errorResp);
-	}
-}
-
+		/*
+			Pass an async-CGI slot to route(). For non-CGI requests it
+			comes back untouched and the Response is final. For CGI
+			requests the Router forks the child and fills the slot -
+			we then park the connection (CONN_CGI_WAIT), register the
+			pipe fds in epoll, and answer the client later from
+			finishActiveCgi() when the script's output is complete.
+		*/
+		Router::CgiExecution exec;
+		exec.activeCount = _activeCgiCount;
+
+		/*
+			Virtual-host resolution, memoized per connection: the
+			first request resolves Host -> server block through the
+			Router's index, every further keep-alive request with the
+			same Host reuses the parked pointer. The generation stamp
+			makes a SIGHUP reload (retired config, new index) a cache
+			miss instead of a stale route.
+		*/
+		const std::string& hostHeader = request->getHeader("Host");
+		unsigned long configGen = _router.getConfigGeneration();
+		const ServerConfig* vhost = conn.getCachedVhost(hostHeader, configGen);
+		if (!vhost)
+		{
+			vhost = _router.findServer(conn.getServerPort(), hostHeader);
+			if (vhost)
+			{
+				conn.cacheVhost(hostHeader, vhost, configGen);
+			}
+		}
+
+		unsigned long routeStart = Stats::enabled() ? Stats::nowUs() : 0;
+		Response response = _router.route(*request, conn.getServerPort(), &exec, vhost);
+		if (Stats::enabled())
+		{
+			Stats::record(Stats::STAGE_ROUTE, Stats::nowUs() - routeStart);
+		}
+
+		if (exec.deferred)
+		{
+			/*
+				cgi_workers cap reached: no child was forked. Park the
+				connection and queue it - startPendingCgi() retries it
+				as soon as a running script frees a slot.
+			*/
+			conn.setState(CONN_CGI_WAIT);
+			_cgiPendingClients.push_back(conn.getFd());
+			std::cout << "  CGI deferred for client fd=" << conn.getFd()
+					  << " (" << _activeCgiCount << " workers busy, "
+					  << _cgiPendingClients.size() << " queued)" << std::endl;
+			return;
+		}
+
+		if (exec.started)
+		{
+			ActiveCgi* cgi = new ActiveCgi();
+			cgi->pid = exec.pid;
+			cgi->stdinFd = exec.stdinFd;
+			cgi->stdoutFd = exec.stdoutFd;
+			cgi->clientFd = conn.getFd();
+			cgi->input = exec.body;
+			cgi->maxOutput = exec.maxOutput;
+			cgi->startTime = time(NULL);
+			if (Stats::enabled())
+			{
+				cgi->startUs = Stats::nowUs();
+			}
+
+			// Spilled body: stream it from the parser's temp file in
+			// bounded chunks (see handleCgiEvent) instead of holding
+			// the whole upload in cgi->input
+			if (!exec.bodyFile.empty())
+			{
+				cgi->inputFd = open(exec.bodyFile.c_str(), O_RDONLY);
+				if (cgi->inputFd < 0)
+				{
+					std::cerr << "  open() failed for CGI body file "
+							  << exec.bodyFile << ": " << strerror(errno)
+							  << std::endl;
+					// Script just gets an empty body
+				}
+			}
+
+			// stdout must be in the epoll set or the output is lost -
+			// if that fails, give up on this execution entirely
+			if (!addToEpoll(cgi->stdoutFd, EPOLLIN))
+			{
+				kill(cgi->pid, SIGKILL);
+				_cgiReapList.push_back(cgi->pid);
+				close(cgi->stdinFd);
+				close(cgi->stdoutFd);
+				delete cgi;
+				Response errorResp = Response::error(500);
+				conn.setResponse(errorResp);
+				return;
+			}
+			_cgiPipes[cgi->stdoutFd] = cgi;
+
+			if (cgi->input.empty() && cgi->inputFd < 0)
+			{
+				// No body to feed - close stdin right away so the
+				// script sees EOF instead of blocking on read()
+				close(cgi->stdinFd);
+				cgi->stdinFd = -1;
+			}
+			else if (addToEpoll(cgi->stdinFd, EPOLLOUT))
+			{
+				_cgiPipes[cgi->stdinFd] = cgi;
+			}
+			else
+			{
+				// Can't monitor stdin: the script just gets a
+				// truncated (empty) body - it may still produce a
+				// sensible response or a sensible error
+				close(cgi->stdinFd);
+				cgi->stdinFd = -1;
+			}
+
+			conn.setState(CONN_CGI_WAIT);
+			++_activeCgiCount;
+			++Counters::cgiStarted;
+			++Counters::cgiActive;
+			std::cout << "  CGI started (pid=" << cgi->pid
+					  << ") for client fd=" << cgi->clientFd
+					  << " (" << _activeCgiCount << " running)" << std::endl;
+			return;
+		}
+
+		// One access line per completed request (CGI requests get
+		// theirs when the script finishes - see finishActiveCgi())
+		Logger::access(conn.getClientIP(), request->getMethod(),
+						request->getUri(), request->getHttpVersion(),
+						response.getStatusCode(), response.getSize());
+		conn.setResponse(response);
+	}
+	else
+	{
+		// No config - send error
+		Response errorResp = Response::error(500);
+		conn.setResponse(errorResp);
+	}
+}
+
 
 /*
 	closeClientConnection() - Clean up a client connection
@@ -1062,48 +1762,935 @@ void Server::processRequest(Connection& conn)
 */
 void Server::closeClientConnection(int clientFd)
 {
-	std::cout << "  Closing client fd=" << clientFd << std::endl;
+	LOG_DEBUG("  Closing client fd=" << clientFd);
+
+	// If a CGI script is still running for this client, kill it -
+	// nobody is left to receive its output
+	abortCgiForClient(clientFd);
+
+	// Drop the client from the CGI wait queue if it was parked there
+	for (size_t i = 0; i < _cgiPendingClients.size(); ++i)
+	{
+		if (_cgiPendingClients[i] == clientFd)
+		{
+			_cgiPendingClients.erase(_cgiPendingClients.begin() + i);
+			break;
+		}
+	}
 
 	removeFromEpoll(clientFd);
 	close(clientFd);
-	_connections.erase(clientFd);
 
-	std::cout << "  Client closed (remaining: " << _connections.size() << ")" << std::endl;
+	Connection* conn = getConnection(clientFd);
+	if (conn)
+	{
+		// Release this connection's per-IP slot (erase at zero so the
+		// map only ever holds IPs with live connections)
+		std::map<std::string, int>::iterator ipIt =
+			_ipConnCount.find(conn->getClientIP());
+		if (ipIt != _ipConnCount.end() && --ipIt->second <= 0)
+		{
+			_ipConnCount.erase(ipIt);
+		}
+
+		delete conn;
+		_connTable[clientFd] = NULL;
+		--_connectionCount;
+		if (Counters::activeConnections > 0)
+		{
+			--Counters::activeConnections;
+		}
+	}
+
+	LOG_DEBUG("  Client closed (remaining: " << _connectionCount << ")");
+}
+
+
+// =================================================================
+//  TIMER WHEEL (connection timeouts)
+// =================================================================
+
+/*
+	scheduleTimeout() - Insert a connection into the timer wheel
+
+	One slot per second; the expiry time hashes to its slot with a
+	simple modulo. Entries for a future revolution share the slot with
+	nearer ones - advanceTimerWheel() re-checks real deadlines, so
+	they're simply re-hashed when the slot fires early.
+*/
+void Server::scheduleTimeout(int clientFd, time_t expiry)
+{
+	_timerWheel[expiry % TIMER_WHEEL_SIZE].push_back(clientFd);
+}
+
+
+/*
+	advanceTimerWheel() - Process wheel slots due since last tick
+
+	The lazy-renewal trick: Connection::updateActivity() never touches
+	the wheel (that would be a delete + insert on every read/write).
+	Instead, when an entry's slot fires we compare against the
+	connection's actual, phase-aware deadline (see
+	Connection::getTimeoutDeadline() - header phase is an absolute
+	deadline, body and keep-alive phases are idle-based).
+
+	If activity pushed the deadline forward, the entry is re-hashed
+	into the new slot and nothing else happens. Each connection is
+	therefore touched at most once per timeout period (plus once per
+	wheel revolution for timeouts longer than the wheel), instead of
+	once per cleanup pass.
+*/
+void Server::advanceTimerWheel()
+{
+	time_t now = time(NULL);
+
+	if (_lastWheelTick == 0)
+	{
+		// First tick: nothing scheduled before startup
+		_lastWheelTick = now;
+		return;
+	}
+
+	// Process at most one full revolution - if the loop somehow
+	// stalled longer than that, every slot gets visited exactly once
+	time_t from = _lastWheelTick + 1;
+	if (now - from >= TIMER_WHEEL_SIZE)
+	{
+		from = now - (TIMER_WHEEL_SIZE - 1);
+	}
+
+	for (time_t tick = from; tick <= now; ++tick)
+	{
+		std::vector<int>& slot = _timerWheel[tick % TIMER_WHEEL_SIZE];
+		if (slot.empty())
+		{
+			continue;
+		}
+
+		// Swap out the slot: re-hashed entries may land back in this
+		// very slot (next revolution) and must not be re-visited now
+		std::vector<int> due;
+		due.swap(slot);
+
+		for (size_t i = 0; i < due.size(); ++i)
+		{
+			int fd = due[i];
+
+			Connection* conn = getConnection(fd);
+			if (!conn)
+			{
+				continue;	// Closed since scheduling - lazy delete
+			}
+
+			time_t deadline = conn->getTimeoutDeadline(
+									CONNECTION_TIMEOUT_SEC,
+									HEADER_TIMEOUT_SEC,
+									BODY_TIMEOUT_SEC);
+			if (deadline <= now)
+			{
+				std::cout << "  Client fd=" << fd << " timed out" << std::endl;
+				++Counters::timeouts;
+				closeClientConnection(fd);
+			}
+			else
+			{
+				// Still active - re-hash to its current deadline
+				scheduleTimeout(fd, deadline);
+			}
+		}
+	}
+
+	_lastWheelTick = now;
+}
+
+
+/*
+	enforceMemoryBudget() - Keep total buffer memory under the cap
+
+	memory_budget caps the sum of all Connection buffer capacities
+	(tracked live in Counters::bufferedBytes). When a burst of large
+	responses pushes the worker over the cap, we close idle
+	keep-alive connections - CONN_READING, nothing to write, no I/O
+	in the last second - oldest first, until back under budget.
+	Each close releases that connection's buffers (the destructor
+	reports them back to the gauge), so memory tracks ACTIVE work
+	instead of the largest response each connection ever served.
+
+	Connections that are reading, writing, or parked on CGI are
+	never shed: pressure reclaims history, not in-flight requests.
+*/
+void Server::enforceMemoryBudget()
+{
+	if (!_config)
+	{
+		return;
+	}
+	size_t budget = _config->getMemoryBudget();
+	if (budget == 0 || Counters::bufferedBytes <= budget)
+	{
+		return;
+	}
+
+	// Collect idle candidates, oldest activity first
+	time_t now = time(NULL);
+	std::vector<std::pair<time_t, int> > idle;
+	for (size_t fd = 0; fd < _connTable.size(); ++fd)
+	{
+		Connection* conn = _connTable[fd];
+		if (conn
+			&& conn->getState() == CONN_READING
+			&& !conn->hasDataToWrite()
+			&& now - conn->getLastActivity() >= 1)
+		{
+			idle.push_back(std::make_pair(conn->getLastActivity(), (int)fd));
+		}
+	}
+	std::sort(idle.begin(), idle.end());
+
+	size_t shed = 0;
+	for (size_t i = 0; i < idle.size() && Counters::bufferedBytes > budget; ++i)
+	{
+		closeClientConnection(idle[i].second);
+		++shed;
+	}
+
+	if (shed > 0)
+	{
+		std::ostringstream msg;
+		msg << "Memory budget: shed " << shed << " idle connection(s) ("
+			<< Counters::bufferedBytes << "/" << budget << " bytes buffered)";
+		Logger::info(msg.str());
+	}
+}
+
+
+// =================================================================
+//  ASYNC CGI HANDLING
+// =================================================================
+
+/*
+	isCgiFd() - Check if FD belongs to an active CGI pipe
+
+	Quick lookup in the _cgiPipes map (both stdin and stdout fds of
+	every in-flight execution are registered there).
+*/
+bool Server::isCgiFd(int fd) const
+{
+	return _cgiPipes.find(fd) != _cgiPipes.end();
+}
+
+
+/*
+	handleCgiEvent() - Process events on a CGI pipe fd
+
+	This is the async counterpart of CGI::execute()'s blocking
+	write-body / read-output sequence, cut into epoll-sized pieces:
+
+	stdin pipe (EPOLLOUT):
+		Write the next chunk of the request body. When everything is
+		written (or the script closed its stdin early - EPIPE), close
+		our end so the script sees EOF.
+
+	stdout pipe (EPOLLIN/EPOLLHUP):
+		Read chunks into cgi->output. read() == 0 means the script
+		closed stdout (normally: exited) - the output is complete and
+		finishActiveCgi() builds the client's response.
+
+	CGI pipes are registered level-triggered (like listen sockets),
+	so a partial write/read simply re-notifies on the next wait.
+*/
+void Server::handleCgiEvent(int fd, uint32_t events)
+{
+	std::map<int, ActiveCgi*>::iterator it = _cgiPipes.find(fd);
+	if (it == _cgiPipes.end())
+	{
+		return;
+	}
+
+	ActiveCgi* cgi = it->second;
+
+	// -----------------------------------------
+	//  stdin pipe: feed the request body
+	// -----------------------------------------
+	if (fd == cgi->stdinFd)
+	{
+		bool done = false;
+
+		if (events & (EPOLLERR | EPOLLHUP))
+		{
+			/*
+				Script closed its stdin without reading the whole body
+				(common: GET-style scripts ignore stdin entirely).
+				Not an error for us - just stop feeding.
+			*/
+			done = true;
+		}
+
+		while (!done)
+		{
+			// Refill from the spill file when the chunk is consumed -
+			// this is what keeps memory flat for GB-sized bodies:
+			// only one 64 KB chunk is in flight at any time
+			if (cgi->inputOffset >= cgi->input.size())
+			{
+				if (cgi->inputFd < 0)
+				{
+					break;	// Everything written
+				}
+
+				char chunk[65536];
+				ssize_t bytesRead = read(cgi->inputFd, chunk, sizeof(chunk));
+				if (bytesRead <= 0)
+				{
+					// EOF (or read error): body fully streamed
+					close(cgi->inputFd);
+					cgi->inputFd = -1;
+					break;
+				}
+				cgi->input.assign(chunk, (size_t)bytesRead);
+				cgi->inputOffset = 0;
+			}
+
+			ssize_t written = write(fd,
+									cgi->input.data() + cgi->inputOffset,
+									cgi->input.size() - cgi->inputOffset);
+			if (written > 0)
+			{
+				cgi->inputOffset += (size_t)written;
+			}
+			else
+			{
+				if (errno == EAGAIN || errno == EWOULDBLOCK)
+				{
+					// Pipe buffer full - wait for the next EPOLLOUT
+					return;
+				}
+				// EPIPE or other error - stop feeding
+				done = true;
+			}
+		}
+
+		// Body fully written (or feeding abandoned): close our end so
+		// the script's read() returns 0 and it can finish up
+		if (cgi->inputFd >= 0)
+		{
+			close(cgi->inputFd);
+			cgi->inputFd = -1;
+		}
+		removeFromEpoll(fd);
+		close(fd);
+		_cgiPipes.erase(fd);
+		cgi->stdinFd = -1;
+		return;
+	}
+
+	// -----------------------------------------
+	//  stdout pipe: collect the script output
+	// -----------------------------------------
+	if (fd == cgi->stdoutFd)
+	{
+		char buffer[8192];
+
+		while (true)
+		{
+			ssize_t bytesRead = read(fd, buffer, sizeof(buffer));
+
+			if (bytesRead > 0)
+			{
+				cgi->outputBytes += (size_t)bytesRead;
+
+				/*
+					cgi_max_output cap: a runaway script is killed, it
+					does not matter whether we were buffering or
+					streaming. Mid-stream the 200 and some body are
+					already on the wire, so the only honest answer is
+					to drop the connection (the unterminated chunked
+					framing tells the client the body is truncated);
+					while still buffering, the client gets a clean 502.
+				*/
+				if (cgi->maxOutput != 0 && cgi->outputBytes > cgi->maxOutput)
+				{
+					std::cout << "  CGI pid=" << cgi->pid
+							  << " exceeded cgi_max_output ("
+							  << cgi->maxOutput << " bytes) - killed"
+							  << std::endl;
+					if (cgi->streaming)
+					{
+						// closeClientConnection() aborts the CGI too
+						closeClientConnection(cgi->clientFd);
+					}
+					else
+					{
+						// finishActiveCgi() only reaps - make sure the
+						// child actually stops producing first
+						kill(cgi->pid, SIGKILL);
+						finishActiveCgi(cgi, 502);
+					}
+					return;
+				}
+
+				if (cgi->streaming)
+				{
+					// Headers already sent - frame the fragment as a
+					// chunk straight onto the client's write buffer
+					Connection* conn = getConnection(cgi->clientFd);
+					if (conn)
+					{
+						conn->appendChunk(buffer, (size_t)bytesRead);
+
+						/*
+							Backpressure: the client is slower than the
+							script. Stop reading stdout - the pipe
+							fills, the script blocks in write(), and
+							our buffering stays bounded at the
+							watermark plus one pipe. Reads resume from
+							resumePausedCgi() once the client drains.
+						*/
+						if (conn->getWriteBacklog() > CGI_STREAM_BACKPRESSURE_BYTES)
+						{
+							removeFromEpoll(cgi->stdoutFd);
+							cgi->readPaused = true;
+							if (!flushClientWrites(*conn))
+							{
+								// Dead client - this aborts the CGI too
+								closeClientConnection(cgi->clientFd);
+							}
+							return;
+						}
+					}
+					continue;
+				}
+
+				cgi->output.append(buffer, (size_t)bytesRead);
+
+				/*
+					Header cap: no blank line after this much output
+					means the script is not emitting CGI headers at
+					all - stop buffering and fail fast instead of
+					letting "headers" grow without bound. (Once the
+					separator is seen, HTTP/1.0 clients keep buffering
+					the body here - that path is bounded by
+					cgi_max_output above.)
+				*/
+				if (cgi->output.size() > CGI_MAX_HEADER_SIZE
+					&& cgi->output.find("\r\n\r\n") == std::string::npos
+					&& cgi->output.find("\n\n") == std::string::npos)
+				{
+					std::cout << "  CGI pid=" << cgi->pid
+							  << " emitted no header block within "
+							  << CGI_MAX_HEADER_SIZE << " bytes - killed"
+							  << std::endl;
+					kill(cgi->pid, SIGKILL);
+					finishActiveCgi(cgi, 502);
+					return;
+				}
+
+				// Headers complete? Start streaming the rest as chunks
+				if (!tryStartCgiStream(cgi))
+				{
+					// Client died on the first frames - this aborts
+					// the CGI too; cgi is freed, stop touching it
+					closeClientConnection(cgi->clientFd);
+					return;
+				}
+			}
+			else if (bytesRead == 0)
+			{
+				// EOF: the script closed stdout - output is complete
+				finishActiveCgi(cgi, 0);
+				return;
+			}
+			else
+			{
+				if (errno == EAGAIN || errno == EWOULDBLOCK)
+				{
+					// Drained for now - more output will re-notify.
+					// Freshly framed chunks won't generate an event
+					// on their own, so start sending them here.
+					if (cgi->streaming)
+					{
+						Connection* conn = getConnection(cgi->clientFd);
+						if (conn && !flushClientWrites(*conn))
+						{
+							// Dead client - aborts the CGI too
+							closeClientConnection(cgi->clientFd);
+						}
+					}
+					return;
+				}
+				// Read error: treat whatever we have as a bad gateway
+				finishActiveCgi(cgi, 502);
+				return;
+			}
+		}
+	}
+}
+
+
+/*
+	tryStartCgiStream() - Switch an execution to chunked streaming
+
+	Looks for the end of the CGI header block in the buffered output.
+	Once found, the parked client gets a chunked-mode Response built
+	from just the headers, everything after the blank line is framed
+	as the first chunk(s), and cgi->streaming flips so later pipe
+	reads bypass the buffer entirely. The client starts receiving the
+	body while the script is still computing the rest of it.
+*/
+bool Server::tryStartCgiStream(ActiveCgi* cgi)
+{
+	// Find the header/body separator (CGI allows \r\n\r\n or \n\n)
+	size_t sepLen = 4;
+	size_t pos = cgi->output.find("\r\n\r\n");
+	if (pos == std::string::npos)
+	{
+		pos = cgi->output.find("\n\n");
+		sepLen = 2;
+	}
+	if (pos == std::string::npos)
+	{
+		return true;	// Headers incomplete - keep buffering
+	}
+
+	Connection* conn = getConnection(cgi->clientFd);
+	if (!conn || conn->getState() != CONN_CGI_WAIT)
+	{
+		return true;	// Client gone or busy - the EOF path sorts it out
+	}
+
+	// HTTP/1.0 clients don't understand chunked encoding - keep the
+	// old buffer-everything behaviour for them
+	const Request* request = conn->getRequest();
+	if (request && request->getHttpVersion() == "HTTP/1.0")
+	{
+		return true;
+	}
+
+	Response response = _router.startCgiStream(cgi->output.substr(0, pos + sepLen));
+	if (!response.isChunked())
+	{
+		return true;	// Malformed headers - EOF path reports the 502
+	}
+
+	conn->setResponse(response);
+
+	// Access line at stream start: a live chunked stream has no final
+	// body length yet, so the logged size covers the headers only
+	if (request)
+	{
+		Logger::access(conn->getClientIP(), request->getMethod(),
+						request->getUri(), request->getHttpVersion(),
+						response.getStatusCode(), response.getSize());
+	}
+
+	// Whatever body bytes arrived along with the headers become the
+	// first chunk frame
+	if (cgi->output.size() > pos + sepLen)
+	{
+		conn->appendChunk(cgi->output.data() + pos + sepLen,
+							cgi->output.size() - (pos + sepLen));
+	}
+	cgi->output.clear();
+	cgi->streaming = true;
+
+	// Start pushing the headers and first chunk right away - parking
+	// them on the write buffers generates no epoll event by itself
+	if (!flushClientWrites(*conn))
+	{
+		return false;
+	}
+
+	std::cout << "  CGI streaming started (pid=" << cgi->pid
+			  << ", client fd=" << cgi->clientFd << ")" << std::endl;
+	return true;
+}
+
+
+/*
+	resumePausedCgi() - Restart stdout reads after the client drained
+
+	The streaming backpressure pause (see the stdout branch of
+	handleCgiPipeEvent) took the script's stdout out of the epoll set.
+	Once the client's write backlog falls back under the watermark,
+	put it back - the pipe has been filling meanwhile, so the next
+	epoll_wait() delivers the pending output immediately.
+*/
+void Server::resumePausedCgi(int clientFd)
+{
+	for (std::map<int, ActiveCgi*>::iterator it = _cgiPipes.begin();
+		 it != _cgiPipes.end(); ++it)
+	{
+		ActiveCgi* cgi = it->second;
+		if (cgi->clientFd != clientFd || !cgi->readPaused)
+		{
+			continue;
+		}
+
+		Connection* conn = getConnection(clientFd);
+		if (conn && conn->getWriteBacklog() > CGI_STREAM_BACKPRESSURE_BYTES)
+		{
+			return;	// Still too full - stay paused
+		}
+
+		if (cgi->stdoutFd >= 0)
+		{
+			addToEpoll(cgi->stdoutFd, EPOLLIN);
+		}
+		cgi->readPaused = false;
+		return;
+	}
 }
 
 
 /*
-	cleanupTimedOutConnections() - Remove stale connections
+	finishActiveCgi() - Complete a CGI execution and answer the client
 
-	Connections that have been idle for too long are closed.
-	This prevents resource exhaustion from abandoned connections.
+	Tears down the execution in one place:
+	1. Deregister/close both pipe fds
+	2. Reap the child (or queue it for WNOHANG reaping if it hasn't
+	   quite exited yet)
+	3. Build the Response - from the collected output on success,
+	   from Response::error() on failure (504 timeout, 502 pipe error)
+	4. Un-park the client connection and re-arm its epoll events
 
-	Called periodically from the main event loop.
+	The ActiveCgi is deleted here; 'cgi' is invalid afterwards.
 */
-void Server::cleanupTimedOutConnections()
+void Server::finishActiveCgi(ActiveCgi* cgi, int errorCode)
 {
-	std::vector<int> toClose;
+	// Fork-to-last-byte duration, whatever the outcome - timeouts
+	// and pipe errors belong in the cgi histogram too
+	if (Stats::enabled() && cgi->startUs != 0)
+	{
+		Stats::record(Stats::STAGE_CGI, Stats::nowUs() - cgi->startUs);
+	}
 
-	for (std::map<int, Connection>::iterator it = _connections.begin();
-		 it != _connections.end(); ++it)
+	// Step 1: Close and deregister both pipes
+	if (cgi->stdinFd >= 0)
 	{
-		Connection& conn = it->second;
+		removeFromEpoll(cgi->stdinFd);
+		close(cgi->stdinFd);
+		_cgiPipes.erase(cgi->stdinFd);
+		cgi->stdinFd = -1;
+	}
+	if (cgi->stdoutFd >= 0)
+	{
+		removeFromEpoll(cgi->stdoutFd);
+		close(cgi->stdoutFd);
+		_cgiPipes.erase(cgi->stdoutFd);
+		cgi->stdoutFd = -1;
+	}
+	if (cgi->inputFd >= 0)
+	{
+		close(cgi->inputFd);
+		cgi->inputFd = -1;
+	}
 
-		if (conn.isTimedOut(CONNECTION_TIMEOUT_SEC))
+	// Step 2: Reap the child without blocking the loop
+	if (cgi->pid > 0)
+	{
+		int status;
+		pid_t reaped = waitpid(cgi->pid, &status, WNOHANG);
+		if (reaped == 0)
 		{
-			std::cout << "  Client fd=" << conn.getFd() << " timed out" << std::endl;
-			toClose.push_back(conn.getFd());
+			// Still exiting - poll it from reapCgiChildren()
+			_cgiReapList.push_back(cgi->pid);
 		}
 	}
 
-	for (size_t i = 0; i < toClose.size(); ++i)
+	// Streaming mode: headers and body chunks are already on the
+	// client's buffers - just terminate the chunk framing. If the
+	// script failed mid-stream the response can't be salvaged (its
+	// status line is long gone), so drop the connection; the
+	// truncated framing tells the client the body is incomplete.
+	if (cgi->streaming)
 	{
-		closeClientConnection(toClose[i]);
+		Connection* connPtr = getConnection(cgi->clientFd);
+		if (connPtr)
+		{
+			if (errorCode != 0)
+			{
+				closeClientConnection(cgi->clientFd);
+			}
+			else
+			{
+				connPtr->endChunkStream();
+				// Send the terminating 0-length chunk frame now -
+				// queueing it generates no epoll event by itself
+				if (!flushClientWrites(*connPtr))
+				{
+					closeClientConnection(cgi->clientFd);
+				}
+			}
+		}
+
+		std::cout << "  CGI stream finished (pid=" << cgi->pid << ")"
+				  << std::endl;
+
+		delete cgi;
+		if (_activeCgiCount > 0)
+		{
+			--_activeCgiCount;
+		}
+		if (Counters::cgiActive > 0)
+		{
+			--Counters::cgiActive;
+		}
+		startPendingCgi();
+		return;
 	}
 
-	if (!toClose.empty())
+	// Step 3: Build the response
+	Response response;
+	if (errorCode != 0)
+	{
+		response = Response::error(errorCode);
+	}
+	else
 	{
-		std::cout << "  Cleaned up " << toClose.size() << " timed-out connection(s)" << std::endl;
+		response = _router.finishCgi(cgi->output);
+	}
+
+	// Step 4: Hand it to the parked client (if it's still around)
+	Connection* connPtr = getConnection(cgi->clientFd);
+	if (connPtr && connPtr->getState() == CONN_CGI_WAIT)
+	{
+		Connection& conn = *connPtr;
+
+		// The deferred access line for this CGI request
+		if (conn.getRequest())
+		{
+			Logger::access(conn.getClientIP(),
+							conn.getRequest()->getMethod(),
+							conn.getRequest()->getUri(),
+							conn.getRequest()->getHttpVersion(),
+							response.getStatusCode(), response.getSize());
+		}
+		conn.setResponse(response);
+
+		// setResponse() moved the state to CONN_WRITING - start
+		// sending right away, the queued bytes raise no event
+		if (!flushClientWrites(conn))
+		{
+			closeClientConnection(cgi->clientFd);
+		}
+	}
+
+	std::cout << "  CGI finished (pid=" << cgi->pid
+			  << ", " << cgi->output.size() << " bytes output)" << std::endl;
+
+	delete cgi;
+
+	// A worker slot just freed up - start the oldest queued request
+	if (_activeCgiCount > 0)
+	{
+		--_activeCgiCount;
+	}
+	if (Counters::cgiActive > 0)
+	{
+		--Counters::cgiActive;
+	}
+	startPendingCgi();
+}
+
+
+/*
+	abortCgiForClient() - Kill the CGI tied to a closing client
+
+	Linear scan over _cgiPipes; fine because in-flight CGI counts are
+	small and this only runs when a client disconnects mid-script.
+*/
+void Server::abortCgiForClient(int clientFd)
+{
+	ActiveCgi* cgi = NULL;
+
+	for (std::map<int, ActiveCgi*>::iterator it = _cgiPipes.begin();
+		 it != _cgiPipes.end(); ++it)
+	{
+		if (it->second->clientFd == clientFd)
+		{
+			cgi = it->second;
+			break;
+		}
+	}
+
+	if (!cgi)
+	{
+		return;
+	}
+
+	std::cout << "  Aborting CGI pid=" << cgi->pid
+			  << " (client fd=" << clientFd << " gone)" << std::endl;
+
+	if (cgi->pid > 0)
+	{
+		kill(cgi->pid, SIGKILL);
+		_cgiReapList.push_back(cgi->pid);
+	}
+
+	if (cgi->stdinFd >= 0)
+	{
+		removeFromEpoll(cgi->stdinFd);
+		close(cgi->stdinFd);
+		_cgiPipes.erase(cgi->stdinFd);
+	}
+	if (cgi->stdoutFd >= 0)
+	{
+		removeFromEpoll(cgi->stdoutFd);
+		close(cgi->stdoutFd);
+		_cgiPipes.erase(cgi->stdoutFd);
+	}
+	if (cgi->inputFd >= 0)
+	{
+		close(cgi->inputFd);
+	}
+
+	delete cgi;
+
+	// The aborted child also frees a worker slot
+	if (_activeCgiCount > 0)
+	{
+		--_activeCgiCount;
+	}
+	if (Counters::cgiActive > 0)
+	{
+		--Counters::cgiActive;
+	}
+	startPendingCgi();
+}
+
+
+/*
+	reapCgiChildren() - Non-blocking reap of exited CGI children
+
+	Called once per event-loop tick. Children land here when a
+	finishActiveCgi()/abortCgiForClient() WNOHANG waitpid() came back
+	"not yet"; polling again a tick later reaps them without ever
+	blocking the loop.
+*/
+void Server::reapCgiChildren()
+{
+	size_t i = 0;
+
+	while (i < _cgiReapList.size())
+	{
+		int status;
+		pid_t reaped = waitpid(_cgiReapList[i], &status, WNOHANG);
+
+		if (reaped == 0)
+		{
+			// Still running/exiting - try again next tick
+			++i;
+		}
+		else
+		{
+			// Reaped (or ECHILD: already gone) - drop from the list
+			_cgiReapList.erase(_cgiReapList.begin() + i);
+		}
+	}
+}
+
+
+/*
+	cleanupTimedOutCgis() - Kill CGI scripts past CGI_TIMEOUT_SEC
+
+	The async path has no blocking poll-loop timeout like
+	CGI::execute() - this periodic check is its replacement. The
+	parked client gets a 504 Gateway Timeout.
+*/
+void Server::cleanupTimedOutCgis()
+{
+	time_t now = time(NULL);
+	std::vector<ActiveCgi*> timedOut;
+
+	for (std::map<int, ActiveCgi*>::iterator it = _cgiPipes.begin();
+		 it != _cgiPipes.end(); ++it)
+	{
+		ActiveCgi* cgi = it->second;
+
+		if (now - cgi->startTime >= CGI_TIMEOUT_SEC)
+		{
+			// Both pipe fds map to the same execution - dedupe
+			bool known = false;
+			for (size_t i = 0; i < timedOut.size(); ++i)
+			{
+				if (timedOut[i] == cgi)
+				{
+					known = true;
+					break;
+				}
+			}
+			if (!known)
+			{
+				timedOut.push_back(cgi);
+			}
+		}
+	}
+
+	for (size_t i = 0; i < timedOut.size(); ++i)
+	{
+		std::cout << "  CGI pid=" << timedOut[i]->pid
+				  << " timed out after " << CGI_TIMEOUT_SEC << "s" << std::endl;
+
+		if (timedOut[i]->pid > 0)
+		{
+			kill(timedOut[i]->pid, SIGKILL);
+		}
+		finishActiveCgi(timedOut[i], 504);
+	}
+}
+
+
+/*
+	startPendingCgi() - Start the next queued CGI request
+
+	Pops waiters (FIFO) until one with a live, still-parked connection
+	is found and re-runs processRequest() on it - the cap check in the
+	Router now passes, so the child actually forks this time. Only one
+	waiter is started per call because only one slot was freed.
+
+	If the retried request produced an immediate response instead of
+	forking (error, or re-deferred by a race), the connection's epoll
+	registration is refreshed here, since no client event will do it.
+*/
+void Server::startPendingCgi()
+{
+	// Never start new work while shutting down
+	if (!_running)
+	{
+		return;
+	}
+
+	while (!_cgiPendingClients.empty())
+	{
+		int clientFd = _cgiPendingClients.front();
+		_cgiPendingClients.erase(_cgiPendingClients.begin());
+
+		Connection* connPtr = getConnection(clientFd);
+		if (!connPtr || connPtr->getState() != CONN_CGI_WAIT)
+		{
+			// Client vanished while waiting - try the next one
+			continue;
+		}
+
+		Connection& conn = *connPtr;
+
+		std::cout << "  Retrying queued CGI for client fd=" << clientFd
+				  << " (" << _cgiPendingClients.size() << " still queued)"
+				  << std::endl;
+
+		// Re-route: forks the child and re-parks the connection, or
+		// produces an immediate (error) response
+		conn.setState(CONN_READING);
+		processRequest(conn);
+
+		// Either a response got queued (send it now - it raises no
+		// event on its own) or the client re-parked in CONN_CGI_WAIT
+		// (flush is a no-op then)
+		if (!flushClientWrites(conn))
+		{
+			closeClientConnection(clientFd);
+		}
+		return;
 	}
 }
 
@@ -1527,21 +3114,58 @@ void Server::stop()
 {
 	if (_running)
 	{
-		std::cout << "\n=== Stopping Server ===" << std::endl;
+		std::cout << "\n=== Stopping Server (worker " << _workerId << ") ===" << std::endl;
 		_running = false;
+
+		// Accept-path summary: how bursty arrivals were, and whether
+		// the kernel dropped SYNs on a full accept queue while we ran
+		std::cout << "Accepted " << _acceptedTotal << " connection(s), "
+				  << "largest burst: " << _acceptBatchMax << std::endl;
+		if (_ipCapRejects > 0)
+		{
+			std::cout << "Rejected " << _ipCapRejects
+					  << " connection(s) over the per-IP cap of "
+					  << MAX_CONNS_PER_IP << std::endl;
+		}
+
+		unsigned long overflows = 0;
+		unsigned long drops = 0;
+		if (readListenQueueStats(overflows, drops))
+		{
+			std::cout << "Listen queue (system-wide): "
+					  << (overflows - _listenOverflowsBase) << " overflow(s), "
+					  << (drops - _listenDropsBase)
+					  << " drop(s) during this run" << std::endl;
+		}
+
+		if (Stats::enabled())
+		{
+			std::cout << "Latency histograms (microseconds):\n"
+					  << Stats::report() << std::flush;
+		}
 	}
 
-	// Close all client connections first
-	std::vector<int> clientFds;
-	for (std::map<int, ClientInfo>::iterator it = _clients.begin();
-			it != _clients.end(); ++it)
+	// Master shuts down its workers first (children have empty lists)
+	if (!_workerPids.empty())
 	{
-		clientFds.push_back(it->first);
+		reapWorkers();
 	}
 
-	for (size_t i = 0; i < clientFds.size(); ++i)
+	// Kill any CGI scripts still running - their clients are about
+	// to be closed anyway. Erasing through abortCgiForClient() keeps
+	// the pipe-closing and child-reaping logic in one place.
+	while (!_cgiPipes.empty())
 	{
-		closeClientConnection(clientFds[i]);
+		abortCgiForClient(_cgiPipes.begin()->second->clientFd);
+	}
+
+	// Close all client connections first
+	for (size_t fd = 0; fd < _connTable.size(); ++fd)
+	{
+		if (_connTable[fd])
+		{
+			closeClientConnection((int)fd);
+		}
 	}
 
 	// Close epoll
@@ -1549,6 +3173,9 @@ void Server::stop()
 
 	// Close listening sockets
 	closeAllSockets();
+
+	// Push out any buffered log lines before the process exits
+	Logger::shutdown();
 }
 
 /*
@@ -1576,6 +3203,22 @@ void Server::closeAllSockets()
 	_listenFds.clear();
 }
 
+/*
+	getConnection() - O(1) connection lookup by fd
+
+	The fd IS the index: the kernel hands out the lowest free
+	descriptor, so the table stays dense and a bounds-checked
+	vector access replaces the old red-black tree walk.
+*/
+Connection* Server::getConnection(int fd)
+{
+	if (fd < 0 || (size_t)fd >= _connTable.size())
+	{
+		return NULL;
+	}
+	return _connTable[fd];
+}
+
 // =================================================================
 //  GETTERS
 // =================================================================
@@ -1598,5 +3241,5 @@ int Server::getEpollFd() const
 
 size_t Server::getClientCount() const
 {
-	return _clients.size();
+	return _connectionCount;
 }
@@ -0,0 +1,161 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Stats.cpp                                          :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: anemet <anemet@student.42luxembourg.lu>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/09/01 14:10:00 by anemet            #+#    #+#             */
+/*   Updated: 2026/09/01 14:10:00 by anemet           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Stats.hpp"
+
+#include <sstream>
+#include <cstring>	// memset()
+#include <time.h>	// clock_gettime(), CLOCK_MONOTONIC
+
+// ==============================================
+//       Static State
+// ==============================================
+
+bool				Stats::_enabled = false;
+Stats::Histogram	Stats::_histograms[Stats::STAGE_COUNT];
+
+
+// Stage names for report(), in enum order
+static const char* const g_stageNames[Stats::STAGE_COUNT] =
+{
+	"parse",
+	"route",
+	"write",
+	"cgi",
+	"total"
+};
+
+
+// =============================================
+//          Public Methods
+// =============================================
+
+void Stats::setEnabled(bool on)
+{
+	_enabled = on;
+}
+
+bool Stats::enabled()
+{
+	return _enabled;
+}
+
+unsigned long Stats::nowUs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long)ts.tv_sec * 1000000UL
+			+ (unsigned long)(ts.tv_nsec / 1000);
+}
+
+void Stats::record(Stage stage, unsigned long us)
+{
+	if (!_enabled || stage < 0 || stage >= STAGE_COUNT)
+	{
+		return;
+	}
+
+	Histogram& h = _histograms[stage];
+
+	if (h.count == 0 || us < h.minUs)
+	{
+		h.minUs = us;
+	}
+	if (us > h.maxUs)
+	{
+		h.maxUs = us;
+	}
+	++h.count;
+	h.sumUs += us;
+
+	// Bucket index = floor(log2(us)); 0 and 1 us share bucket 0
+	int bucket = 0;
+	unsigned long v = us;
+	while (v > 1 && bucket < BUCKET_COUNT - 1)
+	{
+		v >>= 1;
+		++bucket;
+	}
+	++h.buckets[bucket];
+}
+
+std::string Stats::report()
+{
+	std::ostringstream oss;
+	bool any = false;
+
+	for (int s = 0; s < STAGE_COUNT; ++s)
+	{
+		const Histogram& h = _histograms[s];
+		if (h.count == 0)
+		{
+			continue;
+		}
+		any = true;
+
+		oss << "  " << g_stageNames[s] << ": "
+			<< h.count << " sample(s), "
+			<< "min=" << h.minUs << "us "
+			<< "mean=" << (h.sumUs / h.count) << "us "
+			<< "max=" << h.maxUs << "us, "
+			<< "p50=" << percentile(h, 0.50) << "us "
+			<< "p90=" << percentile(h, 0.90) << "us "
+			<< "p99=" << percentile(h, 0.99) << "us "
+			<< "p999=" << percentile(h, 0.999) << "us"
+			<< "\n";
+	}
+
+	if (!any)
+	{
+		oss << "  (no samples recorded)\n";
+	}
+	return oss.str();
+}
+
+void Stats::reset()
+{
+	memset(_histograms, 0, sizeof(_histograms));
+}
+
+
+// =============================================
+//          Private Methods
+// =============================================
+
+/*
+	Walk the buckets until the cumulative count passes p of the
+	total, then report that bucket's upper bound. Power-of-two
+	buckets make this accurate to 2x - coarse, but it separates
+	"microseconds" from "milliseconds" from "seconds", which is
+	the question the histogram exists to answer.
+*/
+unsigned long Stats::percentile(const Histogram& h, double p)
+{
+	unsigned long target = (unsigned long)(p * (double)h.count);
+	if (target >= h.count)
+	{
+		target = h.count - 1;
+	}
+
+	unsigned long seen = 0;
+	for (int b = 0; b < BUCKET_COUNT; ++b)
+	{
+		seen += h.buckets[b];
+		if (seen > target)
+		{
+			// Upper bound of bucket b, capped at the observed max
+			unsigned long bound = (b >= 63) ? h.maxUs : (2UL << b) - 1;
+			return (bound > h.maxUs) ? h.maxUs : bound;
+		}
+	}
+	return h.maxUs;
+}
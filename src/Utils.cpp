@@ -11,6 +11,8 @@
 /* ************************************************************************** */
 
 #include "Utils.hpp"
+#include <zlib.h>		// deflate (gzip response compression)
+#include <cstring>		// memset
 #include <algorithm>
 #include <sstream>
 #include <ctime>
@@ -717,4 +719,56 @@ bool createDirectory(const std::string& path)
 }
 
 
+
+// =======================
+//  Compression
+// =======================
+
+/*
+	gzipCompress() - Gzip a buffer with zlib's deflate
+
+	windowBits 15 + 16 asks deflate for a gzip wrapper (header +
+	CRC32 trailer) instead of a raw zlib stream - browsers expect
+	the gzip framing for Content-Encoding: gzip.
+
+	Compression level 6 is zlib's default speed/ratio tradeoff:
+	text shrinks nearly as well as level 9 at a fraction of the CPU.
+*/
+bool gzipCompress(const std::string& in, std::string& out)
+{
+	out.clear();
+
+	z_stream stream;
+	std::memset(&stream, 0, sizeof(stream));
+
+	if (deflateInit2(&stream, 6, Z_DEFLATED,
+						15 + 16,	// gzip wrapper
+						8, Z_DEFAULT_STRATEGY) != Z_OK)
+	{
+		return false;
+	}
+
+	// deflateBound() gives the worst-case output size, so one
+	// buffer and one deflate() call always suffice
+	uLong bound = deflateBound(&stream, in.size());
+	std::vector<char> buffer(bound);
+
+	stream.next_in = (Bytef*)in.data();
+	stream.avail_in = in.size();
+	stream.next_out = (Bytef*)&buffer[0];
+	stream.avail_out = bound;
+
+	int rc = deflate(&stream, Z_FINISH);
+	if (rc != Z_STREAM_END)
+	{
+		deflateEnd(&stream);
+		return false;
+	}
+
+	out.assign(&buffer[0], stream.total_out);
+	deflateEnd(&stream);
+	return true;
+}
+
+
 } // namespace Utils
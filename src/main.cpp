@@ -117,12 +117,34 @@ static void signalHandler(int signum)
     }
 }
 
+/*
+    reloadHandler - Handle SIGHUP (config reload)
+
+    Following the classic daemon convention: SIGHUP means "re-read
+    your configuration", not "shut down". The handler only FLAGS the
+    reload (requestReload() sets a sig_atomic_t) - parsing the file
+    and swapping the routing tables happen in the event loop, where
+    it's safe. See Server::performConfigReload().
+
+        kill -HUP $(pidof webserv)
+*/
+static void reloadHandler(int signum)
+{
+    (void)signum;
+
+    if (g_server != NULL)
+    {
+        g_server->requestReload();
+    }
+}
+
 /*
     setupSignalHandlers - Register signal handlers
 
     We handle:
     - SIGINT:  Ctrl+C from terminal
     - SIGTERM: Standard termination signal
+    - SIGHUP:  Reload configuration without dropping connections
     - SIGPIPE: Broken pipe (client disconnected while we're writing)
 
     SIGPIPE is particularly important: by default, writing to a closed
@@ -149,6 +171,13 @@ static void setupSignalHandlers()
         std::cerr << "[ERROR] Failed to set SIGTERM handler" << std::endl;
     }
 
+    // SIGHUP triggers a zero-downtime config reload
+    sa.sa_handler = reloadHandler;
+    if (sigaction(SIGHUP, &sa, NULL) == -1)
+    {
+        std::cerr << "[ERROR] Failed to set SIGHUP handler" << std::endl;
+    }
+
     // Ignore SIGPIPE - we'll handle broken pipes via send() return value
     sa.sa_handler = SIG_IGN;
     if (sigaction(SIGPIPE, &sa, NULL) == -1)